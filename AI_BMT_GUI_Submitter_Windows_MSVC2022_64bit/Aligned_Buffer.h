@@ -0,0 +1,83 @@
+#ifndef ALIGNED_BUFFER_H
+#define ALIGNED_BUFFER_H
+
+#include <cstddef>
+#include <new>
+
+using namespace std;
+
+// Fixed-size byte buffer aligned to a cache line (64 bytes by default).
+// Used for memory that is bound once and reused across queries, so SIMD loads and
+// ORT kernels never straddle cache lines at the start of the tensor.
+class AlignedBuffer
+{
+private:
+    void* buffer = nullptr;
+    size_t bufferSize = 0;
+    size_t bufferAlignment = 64;
+
+public:
+    AlignedBuffer() = default;
+
+    explicit AlignedBuffer(size_t byteCount, size_t alignment = 64)
+    {
+        allocate(byteCount, alignment);
+    }
+
+    ~AlignedBuffer()
+    {
+        release();
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : buffer(other.buffer), bufferSize(other.bufferSize), bufferAlignment(other.bufferAlignment)
+    {
+        other.buffer = nullptr;
+        other.bufferSize = 0;
+    }
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            buffer = other.buffer;
+            bufferSize = other.bufferSize;
+            bufferAlignment = other.bufferAlignment;
+            other.buffer = nullptr;
+            other.bufferSize = 0;
+        }
+        return *this;
+    }
+
+    // Replaces the buffer with an uninitialized one of byteCount bytes.
+    void allocate(size_t byteCount, size_t alignment = 64)
+    {
+        release();
+        bufferAlignment = alignment;
+        if (byteCount > 0)
+            buffer = ::operator new(byteCount, align_val_t(alignment));
+        bufferSize = byteCount;
+    }
+
+    void release()
+    {
+        if (buffer != nullptr)
+            ::operator delete(buffer, align_val_t(bufferAlignment));
+        buffer = nullptr;
+        bufferSize = 0;
+    }
+
+    void* data() { return buffer; }
+    const void* data() const { return buffer; }
+    size_t size() const { return bufferSize; }
+    size_t alignment() const { return bufferAlignment; }
+
+    template <typename T>
+    T* as() { return static_cast<T*>(buffer); }
+};
+
+#endif // ALIGNED_BUFFER_H
@@ -1,4 +1,7 @@
 #include "ai_bmt_gui_caller.h"
+#include "ai_bmt_cli_caller.h"
+#include "Image_Preprocessing.h"
+#include "Ort_Inference_Runner.h"
 #include "ai_bmt_interface.h"
 #include <thread>
 #include <chrono>
@@ -28,31 +31,14 @@ using BMTDataType = vector<float>;
 class ImageClassification_Interface_Implementation : public AI_BMT_Interface
 {
 private:
-    Env env;
-    RunOptions runOptions;
-    shared_ptr<Session> session;
-    array<const char*, 1> inputNames;
-    array<const char*, 1> outputNames;
-    MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    OrtInferenceRunner runner;
 
 public:
     virtual void Initialize(string modelPath) override
     {
-        //session initializer
-        SessionOptions sessionOptions;
-        sessionOptions.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-        wstring modelPathwstr(modelPath.begin(), modelPath.end());
-        session = make_shared<Session>(env, modelPathwstr.c_str(), sessionOptions);
-
-        // Get input and output names
-        AllocatorWithDefaultOptions allocator;
-        AllocatedStringPtr inputName = session->GetInputNameAllocated(0, allocator);
-        AllocatedStringPtr outputName = session->GetOutputNameAllocated(0, allocator);
-        inputNames = { inputName.get() };
-        outputNames = { outputName.get() };
-        inputName.release();
-        outputName.release();
+        // Input shape of a single query, used where the model leaves an input dimension dynamic.
+        // Batching is enabled automatically when the model's batch dimension is dynamic (see Ort_Runtime_Config.h for batch_size).
+        runner.initialize(modelPath, { 3, 224, 224 });
     }
 
     virtual Optional_Data getOptionalData() override
@@ -71,73 +57,54 @@ public:
         return data;
     }
 
+    virtual bool isPreprocessingThreadSafe() override
+    {
+        return true;
+    }
+
+    // Must change whenever convertToPreprocessedDataForInference(..) changes, so stale --cache files are rebuilt.
+    virtual string getPreprocessingSignature() override
+    {
+        return "BGR->RGB CHW float32 scale=1/255 mean=0.485,0.456,0.406 std=0.229,0.224,0.225";
+    }
+
     virtual VariantType convertToPreprocessedDataForInference(const string& imagePath) override
     {
         Mat image = imread(imagePath);
         if (image.empty()) {
             throw runtime_error("Failed to load image: " + imagePath);
         }
-
-        // convert BGR to RGB before reshaping
-        cvtColor(image, image, cv::COLOR_BGR2RGB);
-
-        // reshape (3D -> 1D)
-        image = image.reshape(1, 1);
-
-        // uint_8, [0, 255] -> float, [0 and 1] => Normalize number to between 0 and 1, Convert to vector<float> from cv::Mat.
-        vector<float> vec;
-        image.convertTo(vec, CV_32FC1, 1. / 255);
+        if (image.type() != CV_8UC3) {
+            throw runtime_error("Expected an 8-bit 3-channel image: " + imagePath);
+        }
 
         // Mean and Std deviation values
-        const vector<float> means = { 0.485, 0.456, 0.406 };
-        const vector<float> stds = { 0.229, 0.224, 0.225 };
-
-        // Transpose (Height, Width, Channel)(224,224,3) to (Chanel, Height, Width)(3,224,224)
-        BMTDataType output;
-        for (size_t ch = 0; ch < 3; ++ch)
-        {
-            for (size_t i = ch; i < vec.size(); i += 3)
-            {
-                float normalized = (vec[i] - means[ch]) / stds[ch];
-                output.emplace_back(normalized);
-            }
-        }
+        const float means[3] = { 0.485f, 0.456f, 0.406f };
+        const float stds[3] = { 0.229f, 0.224f, 0.225f };
+        static const ChannelNormalization normalization = ChannelNormalization::fromMeanStd(means, stds, 1.0f / 255);
+
+        // Single pass (AVX-512 or AVX2 when available): BGR -> RGB, [0, 255] -> [0, 1], (x - mean) / std,
+        // and transpose (Height, Width, Channel)(H,W,3) to (Channel, Height, Width)(3,H,W) into a pre-sized buffer.
+        BMTDataType output(3 * (size_t)image.rows * image.cols);
+        convertBgrToNormalizedPlanarRgb(image.data, image.rows, image.cols, image.step, normalization, output.data());
+#ifdef AI_BMT_CLI_BUILD
+        return TensorView::wrap(move(output), { 3, image.rows, image.cols });
+#else
         return output;
+#endif
     }
 
     virtual vector<BMTResult> runInference(const vector<VariantType>& data) override
     {
-        const int querySize = data.size();
-        vector<BMTResult> results;
-
-        //onnx option setting
-        const array<int64_t, 4> inputShape = { 1, 3, 224, 224 };
-        const array<int64_t, 2> outputShape = { 1, 1000 };
-
-        for (int i = 0; i < querySize; ++i) {
-            // Prepare input/output tensors
-            BMTDataType imageVec;
-            try {
-                imageVec = get<BMTDataType>(data[i]);
-            }
-            catch (const std::bad_variant_access& e) {
-                cerr << "Error: bad_variant_access at index " << i << ". Reason: " << e.what() << endl;
-                continue;
-            }
-            vector<float> outputData(1000);
-            auto inputTensor = Ort::Value::CreateTensor<float>(memory_info, imageVec.data(), imageVec.size(), inputShape.data(), inputShape.size());
-            auto outputTensor = Ort::Value::CreateTensor<float>(memory_info, outputData.data(), outputData.size(), outputShape.data(), outputShape.size());
-
-            // Run inference
-            session->Run(runOptions, inputNames.data(), &inputTensor, 1, outputNames.data(), &outputTensor, 1);
-
-            // Update results
-            BMTResult result;
-            result.classProbabilities = outputData;
-            results.push_back(result);
-        }
+        AI_BMT_SCOPED_STAGE("stage.runInference");
+        return runner.run(data, [](BMTResult& result, vector<float>&& outputData) {
+            result.classProbabilities = move(outputData);
+        });
+    }
 
-        return results;
+    virtual void releaseResults(vector<BMTResult>& results) override
+    {
+        runner.recycleOutputs(results, &BMTResult::classProbabilities);
     }
 };
 
@@ -150,8 +117,13 @@ int main(int argc, char* argv[])
     try
     {
         shared_ptr<AI_BMT_Interface> interface = make_shared<ImageClassification_Interface_Implementation>();
+#if defined(_WIN32) && !defined(AI_BMT_HEADLESS)
         AI_BMT_GUI_CALLER caller(interface, modelPath);
         return caller.call_BMT_GUI(argc, argv);
+#else
+        AI_BMT_CLI_CALLER caller(interface, modelPath);
+        return caller.call_BMT_CLI(argc, argv);
+#endif
     }
     catch (const exception& ex)
     {
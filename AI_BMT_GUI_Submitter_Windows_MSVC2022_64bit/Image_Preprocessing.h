@@ -0,0 +1,350 @@
+#ifndef IMAGE_PREPROCESSING_H
+#define IMAGE_PREPROCESSING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IMAGE_PREPROCESSING_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang only emit AVX2/AVX-512 code for functions that opt in with a target attribute,
+// so the rest of the binary keeps running on any x86-64 CPU. MSVC accepts the intrinsics directly.
+#if defined(IMAGE_PREPROCESSING_X86) && (defined(__GNUC__) || defined(__clang__))
+#define IMAGE_PREPROCESSING_TARGET(isa) __attribute__((target(isa)))
+#else
+#define IMAGE_PREPROCESSING_TARGET(isa)
+#endif
+
+using namespace std;
+
+// Instruction set used by convertBgrToNormalizedPlanarRgb(..), chosen once at runtime. Levels are ordered: each one
+// implies the ones before it. The post-processing kernels that take a level use AVX2 at every level above Scalar.
+enum class PreprocessingSimdLevel
+{
+    Scalar,
+    AVX2,
+    AVX512BW,  // 64 pixels per step, deinterleaved with in-lane vpshufb
+    AVX512VBMI // 64 pixels per step, deinterleaved with cross-lane vpermb/vpermi2b
+};
+
+// Per-channel affine transform in RGB order: output = pixel * multiplier[c] + offset[c].
+// Folding scale, mean and std into one multiply-add keeps the inner loop to a single FMA.
+struct ChannelNormalization
+{
+    float multiplier[3];
+    float offset[3];
+
+    // output = (pixel * scale - mean[c]) / std[c]
+    static ChannelNormalization fromMeanStd(const float mean[3], const float stddev[3], float scale)
+    {
+        ChannelNormalization normalization;
+        for (int c = 0; c < 3; ++c)
+        {
+            normalization.multiplier[c] = scale / stddev[c];
+            normalization.offset[c] = -mean[c] / stddev[c];
+        }
+        return normalization;
+    }
+};
+
+namespace image_preprocessing_detail
+{
+    // Scalar reference kernel for one row of `width` BGR pixels; also handles the SIMD tails.
+    inline void convertRowScalar(const uint8_t* bgr, size_t width, const ChannelNormalization& n, float* r, float* g, float* b)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            b[x] = bgr[3 * x + 0] * n.multiplier[2] + n.offset[2];
+            g[x] = bgr[3 * x + 1] * n.multiplier[1] + n.offset[1];
+            r[x] = bgr[3 * x + 2] * n.multiplier[0] + n.offset[0];
+        }
+    }
+
+#ifdef IMAGE_PREPROCESSING_X86
+    // pshufb masks that gather byte k of every pixel from 48 interleaved bytes (three 16-byte loads).
+    // masks[k][v][i] selects byte (3 * i + k) if it lies in load v, otherwise -1 (zero).
+    struct BgrShuffleMasks
+    {
+        alignas(16) int8_t masks[3][3][16];
+
+        BgrShuffleMasks()
+        {
+            for (int k = 0; k < 3; ++k)
+                for (int v = 0; v < 3; ++v)
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        int source = 3 * i + k - 16 * v;
+                        masks[k][v][i] = (source >= 0 && source < 16) ? (int8_t)source : (int8_t)-1;
+                    }
+        }
+    };
+
+    inline const BgrShuffleMasks& bgrShuffleMasks()
+    {
+        static const BgrShuffleMasks masks;
+        return masks;
+    }
+
+    // Splits 16 interleaved BGR pixels into one 16-byte vector per channel (B, G, R).
+    IMAGE_PREPROCESSING_TARGET("avx2")
+    inline void deinterleave16(const uint8_t* bgr, const BgrShuffleMasks& shuffle, __m128i channels[3])
+    {
+        const __m128i v0 = _mm_loadu_si128((const __m128i*)(bgr + 0));
+        const __m128i v1 = _mm_loadu_si128((const __m128i*)(bgr + 16));
+        const __m128i v2 = _mm_loadu_si128((const __m128i*)(bgr + 32));
+        for (int k = 0; k < 3; ++k)
+        {
+            __m128i c0 = _mm_shuffle_epi8(v0, _mm_load_si128((const __m128i*)shuffle.masks[k][0]));
+            __m128i c1 = _mm_shuffle_epi8(v1, _mm_load_si128((const __m128i*)shuffle.masks[k][1]));
+            __m128i c2 = _mm_shuffle_epi8(v2, _mm_load_si128((const __m128i*)shuffle.masks[k][2]));
+            channels[k] = _mm_or_si128(_mm_or_si128(c0, c1), c2);
+        }
+    }
+
+    IMAGE_PREPROCESSING_TARGET("avx2,fma")
+    inline void convertRowAvx2(const uint8_t* bgr, size_t width, const ChannelNormalization& n, float* r, float* g, float* b)
+    {
+        const BgrShuffleMasks& shuffle = bgrShuffleMasks();
+        float* planes[3] = { b, g, r };
+        __m256 multiplier[3];
+        __m256 offset[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            multiplier[k] = _mm256_set1_ps(n.multiplier[2 - k]);
+            offset[k] = _mm256_set1_ps(n.offset[2 - k]);
+        }
+
+        size_t x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i channels[3];
+            deinterleave16(bgr + 3 * x, shuffle, channels);
+            for (int k = 0; k < 3; ++k)
+            {
+                __m256 low = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(channels[k]));
+                __m256 high = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(channels[k], 8)));
+                _mm256_storeu_ps(planes[k] + x, _mm256_fmadd_ps(low, multiplier[k], offset[k]));
+                _mm256_storeu_ps(planes[k] + x + 8, _mm256_fmadd_ps(high, multiplier[k], offset[k]));
+            }
+        }
+        convertRowScalar(bgr + 3 * x, width - x, n, r + x, g + x, b + x);
+    }
+
+    // Widens 64 bytes to floats and stores bytes * multiplier + offset to plane[0..63].
+    // The zero-masked forms with full masks compile to the plain instructions; GCC 12 reports the unmasked ones'
+    // undefined source operand as maybe-uninitialized.
+    IMAGE_PREPROCESSING_TARGET("avx512f")
+    inline void storeNormalized64(__m512i bytes, __m512 multiplier, __m512 offset, float* plane)
+    {
+        const __m512 v0 = _mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_maskz_cvtepu8_epi32(0xFFFF, _mm512_maskz_extracti32x4_epi32(0xF, bytes, 0)));
+        const __m512 v1 = _mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_maskz_cvtepu8_epi32(0xFFFF, _mm512_maskz_extracti32x4_epi32(0xF, bytes, 1)));
+        const __m512 v2 = _mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_maskz_cvtepu8_epi32(0xFFFF, _mm512_maskz_extracti32x4_epi32(0xF, bytes, 2)));
+        const __m512 v3 = _mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_maskz_cvtepu8_epi32(0xFFFF, _mm512_maskz_extracti32x4_epi32(0xF, bytes, 3)));
+        _mm512_storeu_ps(plane + 0, _mm512_fmadd_ps(v0, multiplier, offset));
+        _mm512_storeu_ps(plane + 16, _mm512_fmadd_ps(v1, multiplier, offset));
+        _mm512_storeu_ps(plane + 32, _mm512_fmadd_ps(v2, multiplier, offset));
+        _mm512_storeu_ps(plane + 48, _mm512_fmadd_ps(v3, multiplier, offset));
+    }
+
+    // AVX-512BW: lane j of the three vectors holds bytes [16v, 16v + 16) of pixels [16j, 16j + 16), so the 128-bit
+    // pshufb masks of deinterleave16, broadcast to every lane, split 64 pixels with 9 in-lane shuffles.
+    IMAGE_PREPROCESSING_TARGET("avx512f,avx512bw")
+    inline void deinterleave64Bw(const uint8_t* bgr, const BgrShuffleMasks& shuffle, __m512i channels[3])
+    {
+        __m512i v[3];
+        for (int m = 0; m < 3; ++m)
+        {
+            const uint8_t* source = bgr + 16 * m;
+            v[m] = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)source));
+            v[m] = _mm512_inserti32x4(v[m], _mm_loadu_si128((const __m128i*)(source + 48)), 1);
+            v[m] = _mm512_inserti32x4(v[m], _mm_loadu_si128((const __m128i*)(source + 96)), 2);
+            v[m] = _mm512_inserti32x4(v[m], _mm_loadu_si128((const __m128i*)(source + 144)), 3);
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            const __m512i c0 = _mm512_shuffle_epi8(v[0], _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_load_si128((const __m128i*)shuffle.masks[k][0])));
+            const __m512i c1 = _mm512_shuffle_epi8(v[1], _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_load_si128((const __m128i*)shuffle.masks[k][1])));
+            const __m512i c2 = _mm512_shuffle_epi8(v[2], _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_load_si128((const __m128i*)shuffle.masks[k][2])));
+            channels[k] = _mm512_ternarylogic_epi32(c0, c1, c2, 0xFE); // c0 | c1 | c2
+        }
+    }
+
+    // vpermb indices that gather byte k of 64 interleaved pixels (192 bytes, three 64-byte loads).
+    // index[k][i] = (3 * i + k) mod 128 selects from the first two loads through vpermi2b; lanes whose byte lies in the
+    // third load (highMask[k]) are then replaced through vpermb, which reads the same index mod 64.
+    struct BgrPermuteIndices
+    {
+        alignas(64) uint8_t index[3][64];
+        uint64_t highMask[3];
+
+        BgrPermuteIndices()
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                highMask[k] = 0;
+                for (int i = 0; i < 64; ++i)
+                {
+                    const int source = 3 * i + k;
+                    index[k][i] = (uint8_t)(source & 127);
+                    if (source >= 128)
+                        highMask[k] |= 1ull << i;
+                }
+            }
+        }
+    };
+
+    inline const BgrPermuteIndices& bgrPermuteIndices()
+    {
+        static const BgrPermuteIndices indices;
+        return indices;
+    }
+
+    // AVX-512VBMI: two cross-lane byte permutes per channel split 64 pixels.
+    IMAGE_PREPROCESSING_TARGET("avx512f,avx512bw,avx512vbmi")
+    inline void deinterleave64Vbmi(const uint8_t* bgr, const BgrPermuteIndices& permute, __m512i channels[3])
+    {
+        const __m512i v0 = _mm512_loadu_si512((const void*)(bgr + 0));
+        const __m512i v1 = _mm512_loadu_si512((const void*)(bgr + 64));
+        const __m512i v2 = _mm512_loadu_si512((const void*)(bgr + 128));
+        for (int k = 0; k < 3; ++k)
+        {
+            const __m512i index = _mm512_load_si512((const void*)permute.index[k]);
+            const __m512i low = _mm512_permutex2var_epi8(v0, index, v1);
+            channels[k] = _mm512_mask_permutexvar_epi8(low, (__mmask64)permute.highMask[k], index, v2);
+        }
+    }
+
+    // Multipliers and offsets in B, G, R order, like the channels of the deinterleave functions.
+    IMAGE_PREPROCESSING_TARGET("avx512f")
+    inline void loadNormalization512(const ChannelNormalization& n, __m512 multiplier[3], __m512 offset[3])
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            multiplier[k] = _mm512_set1_ps(n.multiplier[2 - k]);
+            offset[k] = _mm512_set1_ps(n.offset[2 - k]);
+        }
+    }
+
+    // 64-pixel blocks; the rest of the row goes through the AVX2 kernel.
+    IMAGE_PREPROCESSING_TARGET("avx512f,avx512bw,avx2,fma")
+    inline void convertRowAvx512Bw(const uint8_t* bgr, size_t width, const ChannelNormalization& n, float* r, float* g, float* b)
+    {
+        const BgrShuffleMasks& shuffle = bgrShuffleMasks();
+        float* planes[3] = { b, g, r };
+        __m512 multiplier[3];
+        __m512 offset[3];
+        loadNormalization512(n, multiplier, offset);
+        size_t x = 0;
+        for (; x + 64 <= width; x += 64)
+        {
+            __m512i channels[3];
+            deinterleave64Bw(bgr + 3 * x, shuffle, channels);
+            for (int k = 0; k < 3; ++k)
+                storeNormalized64(channels[k], multiplier[k], offset[k], planes[k] + x);
+        }
+        convertRowAvx2(bgr + 3 * x, width - x, n, r + x, g + x, b + x);
+    }
+
+    IMAGE_PREPROCESSING_TARGET("avx512f,avx512bw,avx512vbmi,avx2,fma")
+    inline void convertRowAvx512Vbmi(const uint8_t* bgr, size_t width, const ChannelNormalization& n, float* r, float* g, float* b)
+    {
+        const BgrPermuteIndices& permute = bgrPermuteIndices();
+        float* planes[3] = { b, g, r };
+        __m512 multiplier[3];
+        __m512 offset[3];
+        loadNormalization512(n, multiplier, offset);
+        size_t x = 0;
+        for (; x + 64 <= width; x += 64)
+        {
+            __m512i channels[3];
+            deinterleave64Vbmi(bgr + 3 * x, permute, channels);
+            for (int k = 0; k < 3; ++k)
+                storeNormalized64(channels[k], multiplier[k], offset[k], planes[k] + x);
+        }
+        convertRowAvx2(bgr + 3 * x, width - x, n, r + x, g + x, b + x);
+    }
+#endif // IMAGE_PREPROCESSING_X86
+
+    using ConvertRowFunction = void (*)(const uint8_t*, size_t, const ChannelNormalization&, float*, float*, float*);
+
+    inline ConvertRowFunction convertRowFunction(PreprocessingSimdLevel level)
+    {
+#ifdef IMAGE_PREPROCESSING_X86
+        switch (level)
+        {
+        case PreprocessingSimdLevel::AVX512VBMI: return convertRowAvx512Vbmi;
+        case PreprocessingSimdLevel::AVX512BW: return convertRowAvx512Bw;
+        case PreprocessingSimdLevel::AVX2: return convertRowAvx2;
+        default: break;
+        }
+#endif
+        return convertRowScalar;
+    }
+}
+
+// Highest instruction set supported by both the CPU and the OS (AVX and, for AVX-512, opmask/ZMM state enabled via XSAVE).
+inline PreprocessingSimdLevel detectPreprocessingSimdLevel()
+{
+#if defined(IMAGE_PREPROCESSING_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return PreprocessingSimdLevel::Scalar;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave)
+        return PreprocessingSimdLevel::Scalar;
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    if (!avx2 || !fma || (xcr0 & 0x6) != 0x6)
+        return PreprocessingSimdLevel::Scalar;
+    const bool avx512 = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0 && (xcr0 & 0xe6) == 0xe6;
+    if (avx512 && (info[2] & (1 << 1)) != 0)
+        return PreprocessingSimdLevel::AVX512VBMI;
+    return avx512 ? PreprocessingSimdLevel::AVX512BW : PreprocessingSimdLevel::AVX2;
+#elif defined(IMAGE_PREPROCESSING_X86) && (defined(__GNUC__) || defined(__clang__))
+    // __builtin_cpu_supports also checks that the OS saves the AVX/AVX-512 state.
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma"))
+        return PreprocessingSimdLevel::Scalar;
+    if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw"))
+        return PreprocessingSimdLevel::AVX2;
+    return __builtin_cpu_supports("avx512vbmi") ? PreprocessingSimdLevel::AVX512VBMI : PreprocessingSimdLevel::AVX512BW;
+#else
+    return PreprocessingSimdLevel::Scalar;
+#endif
+}
+
+inline PreprocessingSimdLevel preprocessingSimdLevel()
+{
+    static const PreprocessingSimdLevel level = detectPreprocessingSimdLevel();
+    return level;
+}
+
+// Fused single-pass preprocessing of a decoded 8-bit BGR image (e.g., cv::Mat from imread):
+// BGR -> RGB, pixel * scale, (x - mean) / std and (Height, Width, Channel) -> (Channel, Height, Width).
+// `output` must hold 3 * height * width floats; rowStride is the byte distance between rows (cv::Mat::step).
+inline void convertBgrToNormalizedPlanarRgb(const uint8_t* bgr, int height, int width, size_t rowStride,
+    const ChannelNormalization& normalization, float* output,
+    PreprocessingSimdLevel level = preprocessingSimdLevel())
+{
+    const image_preprocessing_detail::ConvertRowFunction convertRow = image_preprocessing_detail::convertRowFunction(level);
+    const size_t planeSize = (size_t)height * width;
+    float* r = output;
+    float* g = output + planeSize;
+    float* b = output + 2 * planeSize;
+    for (int y = 0; y < height; ++y)
+    {
+        const size_t offset = (size_t)y * width;
+        convertRow(bgr + (size_t)y * rowStride, (size_t)width, normalization, r + offset, g + offset, b + offset);
+    }
+}
+
+#endif // IMAGE_PREPROCESSING_H
@@ -1,5 +1,11 @@
 #include "ai_bmt_gui_caller.h"
+#include "ai_bmt_cli_caller.h"
+#include "Image_Preprocessing.h"
+#include "Ort_Inference_Runner.h"
+#include "Result_Encoding.h"
+#include "Yolo_Postprocess.h"
 #include "ai_bmt_interface.h"
+#include "ai_bmt_result_extras.h"
 #include <thread>
 #include <chrono>
 #include <iostream>
@@ -25,34 +31,61 @@ using namespace Ort;
 using BMTDataType = vector<float>;
 
 // To view detailed information on what and how to implement for "AI_BMT_Interface," navigate to its definition (e.g., in Visual Studio/VSCode: Press F12).
-class OnjectDetection_Interface_Implementation : public AI_BMT_Interface
+// detection_output=boxes and result_encoding=float16|int8 keep their outputs in a side table (ai_bmt_result_extras.h), which the command-line
+// driver reports and checks against raw results (--check-results).
+class OnjectDetection_Interface_Implementation : public AI_BMT_Interface, public BMTResultExtrasProvider
 {
 private:
-    Env env;
-    RunOptions runOptions;
-    shared_ptr<Session> session;
-    array<const char*, 1> inputNames;
-    array<const char*, 1> outputNames;
-    MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    OrtInferenceRunner runner;
+    bool encodeOutput = false; // result_encoding=float16|int8
+    ResultEncoder encoder;
+    bool decodeBoxes = false; // detection_output=boxes
+    YoloOutputFormat outputFormat;
+    YoloDecodeSettings decodeSettings;
+    BMTResultExtrasTable extras;
+
+    // detection_layout=v5, v8 or v10 forces the layout; auto reads {N, 6} as end-to-end only for models exported
+    // with "end2end=True" in their metadata (Ultralytics), and fails on it otherwise.
+    YoloOutputFormat selectOutputFormat() const
+    {
+        switch (runner.runtimeConfig().detectionLayout)
+        {
+        case OrtRuntimeConfig::DetectionLayout::V5: return YoloOutputFormat::withLayout(runner.outputShape(), YoloOutputLayout::RowMajor);
+        case OrtRuntimeConfig::DetectionLayout::V8: return YoloOutputFormat::withLayout(runner.outputShape(), YoloOutputLayout::ChannelMajor);
+        case OrtRuntimeConfig::DetectionLayout::V10: return YoloOutputFormat::withLayout(runner.outputShape(), YoloOutputLayout::EndToEnd);
+        default: return YoloOutputFormat::fromShape(runner.outputShape(), OrtRuntimeConfig::toLower(runner.modelMetadata("end2end")) == "true");
+        }
+    }
+
+    void recycleExtras(BMTResultExtras& resultExtras)
+    {
+        encoder.recycle(move(resultExtras.objectDetectionResultEncoded));
+    }
 
 public:
     virtual void Initialize(string modelPath) override
     {
-        //session initializer
-        SessionOptions sessionOptions;
-        sessionOptions.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-        wstring modelPathwstr(modelPath.begin(), modelPath.end());
-        session = make_shared<Session>(env, modelPathwstr.c_str(), sessionOptions);
-
-        // Get input and output names
-        AllocatorWithDefaultOptions allocator;
-        AllocatedStringPtr inputName = session->GetInputNameAllocated(0, allocator);
-        AllocatedStringPtr outputName = session->GetOutputNameAllocated(0, allocator);
-        inputNames = { inputName.get() };
-        outputNames = { outputName.get() };
-        inputName.release();
-        outputName.release();
+        // Input shape of a single query, used where the model leaves an input dimension dynamic.
+        // Batching is enabled automatically when the model's batch dimension is dynamic (see Ort_Runtime_Config.h for batch_size).
+        // The output layout is taken from the model: {25200, 85} for Yolov5, {84, 8400} for Yolov5u, Yolov8, Yolov9, Yolo11
+        // and Yolo12, {300, 6} for Yolov10 (see Yolo_Postprocess.h and detection_layout). Dynamic output dimensions are read from a first run at Initialize.
+        runner.initialize(modelPath, { 3, 640, 640 });
+
+        decodeBoxes = runner.runtimeConfig().detectionBoxes;
+        const OrtRuntimeConfig::ResultEncoding resultEncoding = runner.runtimeConfig().resultEncoding;
+        encodeOutput = !decodeBoxes && resultEncoding != OrtRuntimeConfig::ResultEncoding::Float32;
+        if (encodeOutput)
+            requireResultExtras("result_encoding");
+        encoder.reset(resultEncoding == OrtRuntimeConfig::ResultEncoding::Int8 ? EncodedTensor::Encoding::Int8 : EncodedTensor::Encoding::Float16,
+            runner.outputElementCount(), encodeOutput ? (size_t)runner.batchSize() * runner.sessionCount() : 0);
+        if (decodeBoxes)
+        {
+            requireResultExtras("detection_output=boxes");
+            outputFormat = selectOutputFormat();
+            cout << "Detection output: " << outputFormat.name() << ", " << outputFormat.candidates << " candidates" << endl;
+        }
+        decodeSettings.confThreshold = runner.runtimeConfig().detectionConfThreshold;
+        decodeSettings.iouThreshold = runner.runtimeConfig().detectionIouThreshold;
     }
 
     virtual Optional_Data getOptionalData() override
@@ -71,6 +104,17 @@ public:
         return data;
     }
 
+    virtual bool isPreprocessingThreadSafe() override
+    {
+        return true;
+    }
+
+    // Must change whenever convertToPreprocessedDataForInference(..) changes, so stale --cache files are rebuilt.
+    virtual string getPreprocessingSignature() override
+    {
+        return "BGR->RGB CHW float32 scale=1/255";
+    }
+
     virtual VariantType convertToPreprocessedDataForInference(const string& imagePath) override
     {
         // Load padded image
@@ -79,58 +123,66 @@ public:
             cerr << "Image not found at: " << imagePath << endl;
             throw runtime_error("Image not found!");
         }
-
-        //Convert to float and normalize
-        Mat floatImg;
-        image.convertTo(floatImg, CV_32FC3, 1.0 / 255.0);
-        cvtColor(floatImg, floatImg, COLOR_BGR2RGB);
-
-        //HWC → CHW
-        vector<Mat> chw;
-        split(floatImg, chw);
-        BMTDataType inputTensorValues;
-        for (int c = 0; c < 3; ++c) {
-            inputTensorValues.insert(inputTensorValues.end(),
-                (float*)chw[c].datastart, (float*)chw[c].dataend);
+        if (image.type() != CV_8UC3) {
+            throw runtime_error("Expected an 8-bit 3-channel image: " + imagePath);
         }
+
+        // Single pass (AVX-512 or AVX2 when available): BGR -> RGB, normalize to [0, 1], HWC -> CHW.
+        const float means[3] = { 0.0f, 0.0f, 0.0f };
+        const float stds[3] = { 1.0f, 1.0f, 1.0f };
+        static const ChannelNormalization normalization = ChannelNormalization::fromMeanStd(means, stds, 1.0f / 255);
+
+        BMTDataType inputTensorValues(3 * (size_t)image.rows * image.cols);
+        convertBgrToNormalizedPlanarRgb(image.data, image.rows, image.cols, image.step, normalization, inputTensorValues.data());
+#ifdef AI_BMT_CLI_BUILD
+        return TensorView::wrap(move(inputTensorValues), { 3, image.rows, image.cols });
+#else
         return inputTensorValues;
+#endif
     }
 
     virtual vector<BMTResult> runInference(const vector<VariantType>& data) override
     {
-        cout << "runInference" << endl;
-
-        //onnx option setting
-        const int querySize = data.size();
-        vector<BMTResult> results;
-        array<int64_t, 4> inputShape = { 1, 3, 640, 640 };
-
-        array<int64_t, 3> outputShape = { 1, 25200, 85 }; //Yolov5
-        //array<int64_t, 3> outputShape = { 1, 84, 8400 }; //Yolov5u, Yolov8, Yolov9, Yolo11, Yolo12
-        //array<int64_t, 3> outputShape = { 1, 300, 6 }; //Yolov10
-
-        for (int i = 0; i < querySize; i++) {
-            BMTDataType imageVec;
-            try {
-                imageVec = get<BMTDataType>(data[i]);
-            }
-            catch (const std::bad_variant_access& e) {
-                string errorMessage = "Error: bad_variant_access at index " + to_string(i) + ": " + e.what();
-                throw runtime_error(errorMessage.c_str());
+        AI_BMT_SCOPED_STAGE("stage.runInference");
+        // Extras of results the caller did not release belong to no live result any more.
+        extras.clear([this](BMTResultExtras& resultExtras) { recycleExtras(resultExtras); });
+        return runner.run(data, [this](BMTResult& result, vector<float>&& outputData) {
+            if (!decodeBoxes)
+            {
+                if (encodeOutput)
+                {
+                    encoder.encode(outputData.data(), outputData.size(), extras.emplace(result).objectDetectionResultEncoded);
+                    runner.releaseOutput(move(outputData));
+                }
+                else
+                    result.objectDetectionResult = move(outputData);
+                return;
             }
-            vector<float> outputData(outputShape[1] * outputShape[2]);
-            auto inputTensor = Ort::Value::CreateTensor<float>(memory_info, imageVec.data(), imageVec.size(), inputShape.data(), inputShape.size());
-            auto outputTensor = Value::CreateTensor<float>(memory_info, outputData.data(), outputData.size(), outputShape.data(), outputShape.size());
+            // Compact path: decode + NMS here and hand the raw tensor straight back to the pool.
+            extras.emplace(result).objectDetectionBoxes = decodeYolo(outputData.data(), outputFormat, decodeSettings);
+            runner.releaseOutput(move(outputData));
+        });
+    }
 
-            // Run inference
-            session->Run(runOptions, inputNames.data(), &inputTensor, 1, outputNames.data(), &outputTensor, 1);
+    virtual void releaseResults(vector<BMTResult>& results) override
+    {
+        runner.recycleOutputs(results, &BMTResult::objectDetectionResult);
+        extras.release(results, [this](BMTResultExtras& resultExtras) { recycleExtras(resultExtras); });
+    }
 
-            // Update results
-            BMTResult result;
-            result.objectDetectionResult = outputData;
-            results.push_back(result);
-        }
-        return results;
+    virtual const BMTResultExtras* resultExtras(const BMTResult& result) const override
+    {
+        return extras.find(result);
+    }
+
+    virtual bool referenceBoxes(const BMTResult& raw, vector<Coco17DetectionResult>& boxes) const override
+    {
+        if (!decodeBoxes)
+            return false;
+        if (raw.objectDetectionResult.size() != runner.outputElementCount())
+            throw runtime_error("Raw detection output has " + to_string(raw.objectDetectionResult.size()) + " values, expected " + to_string(runner.outputElementCount()));
+        boxes = decodeYolo(raw.objectDetectionResult.data(), outputFormat, decodeSettings, PreprocessingSimdLevel::Scalar);
+        return true;
     }
 };
 
@@ -143,8 +195,13 @@ public:
 //    try
 //    {
 //        shared_ptr<AI_BMT_Interface> interface = make_shared<OnjectDetection_Interface_Implementation>();
+//#if defined(_WIN32) && !defined(AI_BMT_HEADLESS)
 //        AI_BMT_GUI_CALLER caller(interface, modelPath);
 //        return caller.call_BMT_GUI(argc, argv);
+//#else
+//        AI_BMT_CLI_CALLER caller(interface, modelPath);
+//        return caller.call_BMT_CLI(argc, argv);
+//#endif
 //    }
 //    catch (const exception& ex)
 //    {
@@ -0,0 +1,580 @@
+#ifndef ORT_INFERENCE_RUNNER_H
+#define ORT_INFERENCE_RUNNER_H
+
+#include "ai_bmt_cpu_affinity.h"
+#include "ai_bmt_interface.h"
+#include "ai_bmt_stage_timer.h"
+#include "ai_bmt_trace.h"
+#include "Aligned_Buffer.h"
+#include "Ort_Model_Cache.h"
+#include "Ort_Runtime_Config.h"
+#include "Ort_Shared_Env.h"
+#include "Ort_Tensor_Helper.h"
+#include "Output_Buffer_Pool.h"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <onnxruntime_cxx_api.h>
+
+using namespace std;
+using namespace Ort;
+
+// Session handling shared by the ONNX Runtime example implementations.
+// It owns the session, resolves the model's input/output shapes at Initialize,
+// and runs queries either one at a time or packed into {N, C, H, W} batches,
+// optionally through tensors bound once with Ort::IoBinding.
+// With session_count > 1 it holds a pool of sessions ("throughput streams"): each session has a worker thread
+// that, together with the session's intra-op pool, is pinned to its own core group, and the batches of a
+// runInference(..) call are spread over the workers through a shared queue.
+class OrtInferenceRunner
+{
+private:
+    // One session and the buffers of the Run in flight on it.
+    struct SessionContext
+    {
+        shared_ptr<MappedFile> modelMapping; // Memory-mapped ORT-format model the session uses in place
+        shared_ptr<Session> session;
+        vector<uint8_t> packedInputData;
+        vector<OrtInputView> batchInputViews;
+        vector<float> batchOutputData;
+
+        // IOBinding mode: one full batch worth of aligned input/output memory, bound once at Initialize.
+        AlignedBuffer boundInputData;
+        AlignedBuffer boundOutputData;
+        unique_ptr<IoBinding> ioBinding;
+    };
+
+    // Batches of one run(..) call spread over the session workers.
+    struct PendingRun
+    {
+        mutex runMutex;
+        condition_variable finished;
+        size_t remaining = 0;
+        exception_ptr firstError;
+    };
+
+    RunOptions runOptions;
+    shared_ptr<Env> environment; // Declared before the sessions, which must be destroyed first
+    bool globalThreadPools = false;
+    vector<unique_ptr<SessionContext>> sessions;
+    string inputName;
+    string outputName;
+    array<const char*, 1> inputNames;
+    array<const char*, 1> outputNames;
+    MemoryInfo memory_info = MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+
+    OrtRuntimeConfig config;
+    bool dynamicBatch = false;
+    vector<int64_t> inputSampleShape;  // Shape of one query without the batch dimension, e.g., {3, 224, 224}
+    vector<int64_t> outputSampleShape; // Shape of one result without the batch dimension, e.g., {1000}
+    map<string, string> customMetadata; // Custom metadata map of the model (e.g., Ultralytics exports "end2end", "names")
+    size_t inputSampleSize = 0;
+    size_t outputSampleSize = 0;
+    ONNXTensorElementDataType inputElementType = ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+
+    // Per-query output buffers, sized from the model's output shape at Initialize.
+    OutputBufferPool<float> outputPool;
+
+    // session_count > 1: worker i runs the batches queued in jobs on sessions[i].
+    vector<thread> sessionWorkers;
+    mutex jobMutex;
+    condition_variable jobAvailable;
+    deque<function<void(SessionContext&)>> jobs;
+    bool stoppingWorkers = false;
+
+    static size_t elementCount(const vector<int64_t>& shape)
+    {
+        size_t count = 1;
+        for (int64_t dim : shape)
+            count *= (size_t)dim;
+        return count;
+    }
+
+    // Drops the batch dimension from the model's input shape.
+    // Dimensions left dynamic by the model fall back to the submitter-provided shape (the preprocessed image size).
+    static vector<int64_t> resolveSampleShape(const vector<int64_t>& modelShape, const vector<int64_t>& fallbackShape)
+    {
+        if (modelShape.size() != fallbackShape.size() + 1)
+            return fallbackShape;
+        vector<int64_t> shape(modelShape.begin() + 1, modelShape.end());
+        for (size_t i = 0; i < shape.size(); ++i)
+        {
+            if (shape[i] <= 0)
+                shape[i] = fallbackShape[i];
+        }
+        return shape;
+    }
+
+    static string shapeText(const vector<int64_t>& shape)
+    {
+        string text = "{";
+        for (size_t i = 0; i < shape.size(); ++i)
+            text += (i == 0 ? "" : ", ") + to_string(shape[i]);
+        return text + "}";
+    }
+
+    // Zero-copy view of query i, checked against the model's input size and element type.
+    OrtInputView inputViewAt(const vector<VariantType>& data, size_t i) const
+    {
+        AI_BMT_SCOPED_STAGE("stage.input_view");
+        OrtInputView view;
+        try {
+            view = makeInputView(data[i], inputSampleSize);
+        }
+        catch (const exception& e) {
+            throw runtime_error("Error: invalid input at index " + to_string(i) + ": " + e.what());
+        }
+        if (view.elementType != inputElementType)
+            throw runtime_error("Error: input at index " + to_string(i) + " has element type " + to_string(view.elementType) + ", model expects " + to_string(inputElementType));
+        if (view.shape != nullptr && *view.shape != inputSampleShape)
+            throw runtime_error("Error: input at index " + to_string(i) + " has shape " + shapeText(*view.shape) + ", model expects " + shapeText(inputSampleShape));
+        return view;
+    }
+
+    static vector<int64_t> batchShape(int64_t batch, const vector<int64_t>& sampleShape)
+    {
+        vector<int64_t> shape = { batch };
+        shape.insert(shape.end(), sampleShape.begin(), sampleShape.end());
+        return shape;
+    }
+
+    // Output shape of one query, read from a Run on a zero-filled input. Used when the model leaves output dimensions
+    // dynamic: YOLO exports with dynamic axes, for example, cannot be told apart ({25200, 85} or {84, 8400}) without running.
+    vector<int64_t> probeOutputSampleShape(Session& session)
+    {
+        const vector<int64_t> inputShape = batchShape(1, inputSampleShape);
+        vector<uint8_t> zeros(inputSampleSize * tensorElementSize(inputElementType));
+        Value inputTensor = Value::CreateTensor(memory_info, zeros.data(), zeros.size(), inputShape.data(), inputShape.size(), inputElementType);
+        vector<Value> outputs;
+        try {
+            outputs = session.Run(runOptions, inputNames.data(), &inputTensor, 1, outputNames.data(), 1);
+        }
+        catch (const exception& e) {
+            throw runtime_error("Error: the model's output shape is dynamic and a run on input " + shapeText(inputShape) + " failed: " + e.what());
+        }
+        const vector<int64_t> shape = outputs.front().GetTensorTypeAndShapeInfo().GetShape();
+        if (shape.size() < 2 || shape[0] != 1)
+            throw runtime_error("Error: the model's output shape is dynamic and a run on input " + shapeText(inputShape) + " returned " + shapeText(shape) + ", expected {1, ...}");
+        return vector<int64_t>(shape.begin() + 1, shape.end());
+    }
+
+    // Binds input/output tensors for a full batch once; each Run only refreshes the input contents.
+    void bindPersistentTensors(SessionContext& context)
+    {
+        const size_t batch = (size_t)batchSize();
+        const vector<int64_t> inputShape = batchShape((int64_t)batch, inputSampleShape);
+        const vector<int64_t> outputShape = batchShape((int64_t)batch, outputSampleShape);
+        context.boundInputData.allocate(batch * inputSampleSize * tensorElementSize(inputElementType));
+        context.boundOutputData.allocate(batch * outputSampleSize * sizeof(float));
+
+        Value inputTensor = Value::CreateTensor(memory_info, context.boundInputData.data(), context.boundInputData.size(), inputShape.data(), inputShape.size(), inputElementType);
+        Value outputTensor = Value::CreateTensor<float>(memory_info, context.boundOutputData.as<float>(), batch * outputSampleSize, outputShape.data(), outputShape.size());
+        context.ioBinding = make_unique<IoBinding>(*context.session);
+        context.ioBinding->BindInput(inputName.c_str(), inputTensor);
+        context.ioBinding->BindOutput(outputName.c_str(), outputTensor);
+    }
+
+    // Copies each query's slice of a batched output into a pooled buffer and stores it in its result.
+    template <typename StoreOutput>
+    void splitOutputs(const float* outputData, size_t begin, size_t batch, vector<BMTResult>& results, StoreOutput& storeOutput)
+    {
+        AI_BMT_SCOPED_STAGE("stage.build_results");
+        for (size_t k = 0; k < batch; ++k)
+        {
+            vector<float> queryOutput = outputPool.acquire();
+            const float* first = outputData + k * outputSampleSize;
+            copy(first, first + outputSampleSize, queryOutput.begin());
+            storeOutput(results[begin + k], move(queryOutput));
+        }
+    }
+
+    // Gathers the checked input views of queries [begin, begin + batch) before any tensor is built.
+    void collectInputViews(SessionContext& context, const vector<VariantType>& data, size_t begin, size_t batch)
+    {
+        context.batchInputViews.resize(batch);
+        for (size_t k = 0; k < batch; ++k)
+            context.batchInputViews[k] = inputViewAt(data, begin + k);
+    }
+
+    // Batch of one: the input tensor is bound onto data[begin] and ORT writes into a pooled buffer (no copies).
+    template <typename StoreOutput>
+    void runSingle(SessionContext& context, const vector<VariantType>& data, size_t begin, vector<BMTResult>& results, StoreOutput& storeOutput)
+    {
+        const vector<int64_t> inputShape = batchShape(1, inputSampleShape);
+        const vector<int64_t> outputShape = batchShape(1, outputSampleShape);
+        const OrtInputView view = inputViewAt(data, begin);
+        Value inputTensor{ nullptr };
+        Value outputTensor{ nullptr };
+        vector<float> outputData;
+        {
+            AI_BMT_SCOPED_STAGE("stage.create_tensors");
+            inputTensor = createInputTensor(memory_info, view, inputShape.data(), inputShape.size());
+            outputData = outputPool.acquire();
+            outputTensor = Value::CreateTensor<float>(memory_info, outputData.data(), outputData.size(), outputShape.data(), outputShape.size());
+        }
+
+        // Run inference
+        {
+            AI_BMT_SCOPED_STAGE("stage.session_run");
+            context.session->Run(runOptions, inputNames.data(), &inputTensor, 1, outputNames.data(), &outputTensor, 1);
+        }
+        {
+            AI_BMT_SCOPED_STAGE("stage.build_results");
+            storeOutput(results[begin], move(outputData));
+        }
+    }
+
+    // Packs the queries of this batch into one contiguous {N, C, H, W} tensor and splits the output back.
+    template <typename StoreOutput>
+    void runPacked(SessionContext& context, const vector<VariantType>& data, size_t begin, size_t batch, vector<BMTResult>& results, StoreOutput& storeOutput)
+    {
+        const vector<int64_t> inputShape = batchShape((int64_t)batch, inputSampleShape);
+        const vector<int64_t> outputShape = batchShape((int64_t)batch, outputSampleShape);
+        collectInputViews(context, data, begin, batch);
+        Value inputTensor{ nullptr };
+        Value outputTensor{ nullptr };
+        {
+            AI_BMT_SCOPED_STAGE("stage.create_tensors");
+            for (size_t k = 0; k < batch; ++k)
+            {
+                const OrtInputView& view = context.batchInputViews[k];
+                context.packedInputData.resize(batch * view.byteCount());
+                memcpy(context.packedInputData.data() + k * view.byteCount(), view.data, view.byteCount());
+            }
+            inputTensor = Value::CreateTensor(memory_info, context.packedInputData.data(), context.packedInputData.size(), inputShape.data(), inputShape.size(), inputElementType);
+
+            context.batchOutputData.resize(batch * outputSampleSize);
+            outputTensor = Value::CreateTensor<float>(memory_info, context.batchOutputData.data(), context.batchOutputData.size(), outputShape.data(), outputShape.size());
+        }
+
+        // Run inference
+        {
+            AI_BMT_SCOPED_STAGE("stage.session_run");
+            context.session->Run(runOptions, inputNames.data(), &inputTensor, 1, outputNames.data(), &outputTensor, 1);
+        }
+        splitOutputs(context.batchOutputData.data(), begin, batch, results, storeOutput);
+    }
+
+    // Full batch through the persistent IOBinding: refresh the bound input contents and run.
+    template <typename StoreOutput>
+    void runBound(SessionContext& context, const vector<VariantType>& data, size_t begin, size_t batch, vector<BMTResult>& results, StoreOutput& storeOutput)
+    {
+        collectInputViews(context, data, begin, batch);
+        {
+            AI_BMT_SCOPED_STAGE("stage.create_tensors");
+            uint8_t* inputData = context.boundInputData.as<uint8_t>();
+            for (size_t k = 0; k < batch; ++k)
+            {
+                const OrtInputView& view = context.batchInputViews[k];
+                memcpy(inputData + k * view.byteCount(), view.data, view.byteCount());
+            }
+        }
+
+        // Run inference
+        {
+            AI_BMT_SCOPED_STAGE("stage.session_run");
+            context.session->Run(runOptions, *context.ioBinding);
+        }
+        splitOutputs(context.boundOutputData.as<float>(), begin, batch, results, storeOutput);
+    }
+
+    // Runs one batch on the given session.
+    template <typename StoreOutput>
+    void runBatch(SessionContext& context, const vector<VariantType>& data, size_t begin, size_t batch, vector<BMTResult>& results, StoreOutput& storeOutput)
+    {
+        if (context.ioBinding && batch == (size_t)batchSize())
+            runBound(context, data, begin, batch, results, storeOutput);
+        else if (batch == 1)
+            runSingle(context, data, begin, results, storeOutput);
+        else
+            runPacked(context, data, begin, batch, results, storeOutput);
+    }
+
+    void workerLoop(size_t index, vector<unsigned> cpus)
+    {
+        pinCurrentThread(cpus);
+        SessionContext& context = *sessions[index];
+        while (true)
+        {
+            function<void(SessionContext&)> job;
+            {
+                unique_lock<mutex> lock(jobMutex);
+                jobAvailable.wait(lock, [this] { return stoppingWorkers || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+                job = move(jobs.front());
+                jobs.pop_front();
+            }
+            job(context);
+        }
+    }
+
+    void stopWorkers()
+    {
+        {
+            lock_guard<mutex> lock(jobMutex);
+            stoppingWorkers = true;
+        }
+        jobAvailable.notify_all();
+        for (thread& worker : sessionWorkers)
+            worker.join();
+        sessionWorkers.clear();
+        stoppingWorkers = false;
+    }
+
+    // Ends the profiles of the current sessions (before they are replaced or destroyed).
+    void finishProfiles()
+    {
+        for (const unique_ptr<SessionContext>& context : sessions)
+            TraceRecorder::instance().finishProfileSource(context.get());
+    }
+
+    // Lets the trace recorder end this session's profile and merge it into the Chrome trace.
+    void registerProfile(const SessionContext& context, const string& modelName)
+    {
+        shared_ptr<Session> profiledSession = context.session;
+        TraceRecorder::instance().registerProfileSource(&context, [profiledSession, modelName]() {
+            OrtProfileFile profile;
+            profile.modelName = modelName;
+            profile.startNs = (int64_t)profiledSession->GetProfilingStartTimeNs();
+            AllocatorWithDefaultOptions allocator;
+            profile.path = profiledSession->EndProfilingAllocated(allocator).get();
+            return profile;
+        });
+    }
+
+    static GraphOptimizationLevel graphOptimizationLevel(OrtRuntimeConfig::GraphOptimization optimization)
+    {
+        switch (optimization)
+        {
+        case OrtRuntimeConfig::GraphOptimization::Disabled: return GraphOptimizationLevel::ORT_DISABLE_ALL;
+        case OrtRuntimeConfig::GraphOptimization::Basic: return GraphOptimizationLevel::ORT_ENABLE_BASIC;
+        case OrtRuntimeConfig::GraphOptimization::All: return GraphOptimizationLevel::ORT_ENABLE_ALL;
+        default: return GraphOptimizationLevel::ORT_ENABLE_EXTENDED;
+        }
+    }
+
+public:
+    // Execution mode, graph optimization and thread pools from the runtime config (see Ort_Runtime_Config.h).
+    // cpus: core group of a pooled session. Unless thread_affinity is set, the intra-op pool gets one thread per core
+    // of the group (or intra_op_threads) and its threads are pinned to the group, next to the calling worker.
+    // globalThreadPools: the session runs on the environment's global pools, which replace all thread settings.
+    static SessionOptions createSessionOptions(const OrtRuntimeConfig& config, const vector<unsigned>& cpus = {}, bool globalThreadPools = false)
+    {
+        SessionOptions sessionOptions;
+        sessionOptions.SetExecutionMode(config.parallelExecution ? ExecutionMode::ORT_PARALLEL : ExecutionMode::ORT_SEQUENTIAL);
+        sessionOptions.SetGraphOptimizationLevel(graphOptimizationLevel(config.graphOptimization));
+        if (globalThreadPools)
+        {
+            sessionOptions.DisablePerSessionThreads();
+            return sessionOptions;
+        }
+        const int intraOpThreads = config.resolvedIntraOpThreads();
+        if (intraOpThreads > 0)
+            sessionOptions.SetIntraOpNumThreads(intraOpThreads);
+        if (config.interOpThreads > 0)
+            sessionOptions.SetInterOpNumThreads(config.interOpThreads);
+        sessionOptions.AddConfigEntry("session.intra_op.allow_spinning", config.allowSpinning ? "1" : "0");
+        sessionOptions.AddConfigEntry("session.inter_op.allow_spinning", config.allowSpinning ? "1" : "0");
+        if (!config.threadAffinity.empty())
+            sessionOptions.AddConfigEntry("session.intra_op_thread_affinities", config.threadAffinity.c_str());
+        else if (!cpus.empty())
+        {
+            const size_t threads = intraOpThreads > 0 ? (size_t)intraOpThreads : cpus.size();
+            sessionOptions.SetIntraOpNumThreads((int)threads);
+            // One entry per pool thread besides the caller; ONNX Runtime numbers logical processors from 1.
+            string affinities;
+            for (size_t i = 1; i < threads; ++i)
+                affinities += (i > 1 ? ";" : "") + to_string(cpus[i % cpus.size()] + 1);
+            if (!affinities.empty())
+                sessionOptions.AddConfigEntry("session.intra_op_thread_affinities", affinities.c_str());
+        }
+        return sessionOptions;
+    }
+
+    OrtInferenceRunner() = default;
+    OrtInferenceRunner(const OrtInferenceRunner&) = delete;
+    OrtInferenceRunner& operator=(const OrtInferenceRunner&) = delete;
+
+    ~OrtInferenceRunner()
+    {
+        stopWorkers();
+        finishProfiles();
+    }
+
+    // Loads the model and detects whether its batch dimension is dynamic.
+    // inputShape describes a single query (no batch dimension) and is used where the model metadata does not fix an
+    // input dimension. Output dimensions the model leaves dynamic are taken from one run on a zero-filled input.
+    // Sessions are created in the process-wide environment (Ort_Shared_Env.h).
+    void initialize(const string& modelPath, const vector<int64_t>& inputShape)
+    {
+        config = OrtRuntimeConfig::load(modelPath);
+        stopWorkers();
+        finishProfiles();
+        sessions.clear();
+        environment.reset(); // Lets the shared environment be rebuilt with this config's global thread pools
+        environment = OrtSharedEnv::acquire(config, globalThreadPools);
+        const string modelName = filesystem::path(modelPath).stem().string();
+        const size_t sessionCount = (size_t)config.sessionCount;
+        const vector<vector<unsigned>> cpuGroups = sessionCount > 1 && config.pinSessions ? splitCpuGroups(sessionCount) : vector<vector<unsigned>>(sessionCount);
+        const string optimizedModelPath = OrtModelCache::isEnabled(config) ? OrtModelCache::cachePath(config, modelPath) : "";
+
+        //session initializer
+        for (size_t i = 0; i < sessionCount; ++i)
+        {
+            SessionOptions sessionOptions = createSessionOptions(config, cpuGroups[i], globalThreadPools);
+            // Profile files are named by prefix and start time, so pooled sessions need distinct prefixes.
+            const string profilePrefix = modelName + "_ort_profile" + (sessionCount > 1 ? "_s" + to_string(i) : "");
+            auto context = make_unique<SessionContext>();
+            if (config.profiling)
+            {
+#ifdef _WIN32
+                sessionOptions.EnableProfiling(wstring(profilePrefix.begin(), profilePrefix.end()).c_str());
+#else
+                sessionOptions.EnableProfiling(profilePrefix.c_str());
+#endif
+            }
+            // The first session builds the optimized model cache if needed; the others load it.
+            OrtModelCache::Source source = OrtModelCache::prepare(config, modelPath, optimizedModelPath, sessionOptions);
+            context->modelMapping = source.mapping;
+            context->session = OrtModelCache::createSession(*environment, source, sessionOptions);
+            OrtModelCache::commit(source);
+            if (config.profiling)
+                registerProfile(*context, modelName);
+            sessions.push_back(move(context));
+        }
+        Session* session = sessions.front()->session.get();
+
+        // Get input and output names
+        AllocatorWithDefaultOptions allocator;
+        inputName = session->GetInputNameAllocated(0, allocator).get();
+        outputName = session->GetOutputNameAllocated(0, allocator).get();
+        inputNames = { inputName.c_str() };
+        outputNames = { outputName.c_str() };
+        customMetadata.clear();
+        ModelMetadata metadata = session->GetModelMetadata();
+        for (const AllocatedStringPtr& key : metadata.GetCustomMetadataMapKeysAllocated(allocator))
+            customMetadata[key.get()] = metadata.LookupCustomMetadataMapAllocated(key.get(), allocator).get();
+
+        // Get input and output shapes; a batch dimension of -1 (or a symbolic name) means dynamic.
+        vector<int64_t> modelInputShape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        inputElementType = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType();
+        vector<int64_t> modelOutputShape = session->GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        dynamicBatch = !modelInputShape.empty() && modelInputShape[0] <= 0;
+        inputSampleShape = resolveSampleShape(modelInputShape, inputShape);
+        inputSampleSize = elementCount(inputSampleShape);
+        const bool dynamicOutput = modelOutputShape.size() < 2 || any_of(modelOutputShape.begin() + 1, modelOutputShape.end(), [](int64_t dim) { return dim <= 0; });
+        outputSampleShape = dynamicOutput ? probeOutputSampleShape(*session) : vector<int64_t>(modelOutputShape.begin() + 1, modelOutputShape.end());
+        outputSampleSize = elementCount(outputSampleShape);
+
+        outputPool.reset(outputSampleSize, (size_t)batchSize() * sessionCount);
+        for (const unique_ptr<SessionContext>& context : sessions)
+        {
+            if (config.ioBinding)
+                bindPersistentTensors(*context);
+        }
+        if (sessionCount > 1)
+        {
+            for (size_t i = 0; i < sessionCount; ++i)
+                sessionWorkers.emplace_back(&OrtInferenceRunner::workerLoop, this, i, cpuGroups[i]);
+        }
+    }
+
+    size_t sessionCount() const { return sessions.size(); }
+
+    bool hasDynamicBatch() const { return dynamicBatch; }
+
+    int batchSize() const { return dynamicBatch ? config.batchSize : 1; }
+
+    // Output shape of one query as resolved at initialize(..), e.g., {84, 8400} for a YOLOv8 model.
+    const vector<int64_t>& outputShape() const { return outputSampleShape; }
+
+    size_t outputElementCount() const { return outputSampleSize; }
+
+    // Value of a custom metadata entry of the model, or an empty string when the model has none by that name.
+    string modelMetadata(const string& key) const
+    {
+        auto it = customMetadata.find(key);
+        return it == customMetadata.end() ? "" : it->second;
+    }
+
+    // Settings loaded by the last initialize(..), for implementation-side options (e.g., detection_output).
+    const OrtRuntimeConfig& runtimeConfig() const { return config; }
+
+    // Runs every query and hands each query's output to storeOutput(BMTResult&, vector<float>&&).
+    // Results are returned in the same order as data. With a session pool, storeOutput is called concurrently
+    // for different results.
+    template <typename StoreOutput>
+    vector<BMTResult> run(const vector<VariantType>& data, StoreOutput storeOutput)
+    {
+        const size_t querySize = data.size();
+        const size_t maxBatch = (size_t)batchSize();
+        vector<BMTResult> results(querySize);
+
+        if (sessionWorkers.empty())
+        {
+            SessionContext& context = *sessions.front();
+            for (size_t begin = 0; begin < querySize; begin += maxBatch)
+                runBatch(context, data, begin, min(maxBatch, querySize - begin), results, storeOutput);
+            return results;
+        }
+
+        PendingRun pending;
+        pending.remaining = (querySize + maxBatch - 1) / maxBatch;
+        {
+            lock_guard<mutex> lock(jobMutex);
+            for (size_t begin = 0; begin < querySize; begin += maxBatch)
+            {
+                const size_t batch = min(maxBatch, querySize - begin);
+                jobs.push_back([this, &data, begin, batch, &results, &storeOutput, &pending](SessionContext& context) {
+                    exception_ptr error;
+                    try {
+                        runBatch(context, data, begin, batch, results, storeOutput);
+                    }
+                    catch (...) {
+                        error = current_exception();
+                    }
+                    lock_guard<mutex> lock(pending.runMutex);
+                    if (error && !pending.firstError)
+                        pending.firstError = error;
+                    if (--pending.remaining == 0)
+                        pending.finished.notify_all();
+                });
+            }
+        }
+        jobAvailable.notify_all();
+
+        unique_lock<mutex> lock(pending.runMutex);
+        pending.finished.wait(lock, [&pending] { return pending.remaining == 0; });
+        if (pending.firstError)
+            rethrow_exception(pending.firstError);
+        return results;
+    }
+
+    // Returns the output buffers held by results[i].*field to the pool for the next runInference(..).
+    void recycleOutputs(vector<BMTResult>& results, vector<float> BMTResult::* field)
+    {
+        for (BMTResult& result : results)
+            outputPool.release(move(result.*field));
+    }
+
+    // Returns a single output buffer to the pool, e.g., once storeOutput has reduced it to a compact result.
+    void releaseOutput(vector<float>&& outputData)
+    {
+        outputPool.release(move(outputData));
+    }
+};
+
+#endif // ORT_INFERENCE_RUNNER_H
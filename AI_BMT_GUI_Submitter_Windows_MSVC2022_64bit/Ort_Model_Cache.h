@@ -0,0 +1,138 @@
+#ifndef ORT_MODEL_CACHE_H
+#define ORT_MODEL_CACHE_H
+
+#include "ai_bmt_file_utils.h"
+#include "Ort_Runtime_Config.h"
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <onnxruntime_cxx_api.h>
+
+using namespace std;
+using namespace Ort;
+
+// Cache of graph-optimized models, so Initialize skips graph optimization after the first start
+// (optimized_model_cache=onnx|ort, see Ort_Runtime_Config.h).
+// The first session of a model is created from the original file with SessionOptions::SetOptimizedModelFilePath,
+// which makes ONNX Runtime save the optimized graph. Later sessions load that file with optimizations disabled;
+// ORT-format files can be memory-mapped and used in place (optimized_model_mmap).
+// Files are keyed by a hash of the model content, the ONNX Runtime version, the optimization level and the host
+// (optimized graphs may contain kernels specific to the CPU they were created on).
+class OrtModelCache
+{
+public:
+    // How the next session is loaded.
+    struct Source
+    {
+        string modelPath;               // File passed to the session (original model or cached graph)
+        shared_ptr<MappedFile> mapping; // Cached ORT-format graph mapped in memory; must outlive the session
+        string pendingPath;             // Cache file being written by this session, committed by commit(..)
+        string cachePath;
+    };
+
+private:
+    static string toHex(uint64_t value)
+    {
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", (unsigned long long)value);
+        return text;
+    }
+
+    static uint64_t hashText(const string& text, uint64_t hash = 1469598103934665603ull)
+    {
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static basic_string<ORTCHAR_T> ortPath(const string& path)
+    {
+        return basic_string<ORTCHAR_T>(path.begin(), path.end());
+    }
+
+public:
+    static bool isEnabled(const OrtRuntimeConfig& config)
+    {
+        return config.optimizedModelCache != OrtRuntimeConfig::OptimizedModelCache::Off;
+    }
+
+    // "<dir>/<model stem>.<key>.opt.onnx" or ".ort"; dir defaults to the model's directory.
+    static string cachePath(const OrtRuntimeConfig& config, const string& modelPath)
+    {
+        const bool ortFormat = config.optimizedModelCache == OrtRuntimeConfig::OptimizedModelCache::Ort;
+        uint64_t fileSize = 0;
+        uint64_t key = hashFile(modelPath, fileSize);
+        key = hashText(to_string(fileSize) + "|" + GetVersionString() + "|" + to_string((int)config.graphOptimization) + "|"
+            + (ortFormat ? "ort" : "onnx") + "|" + autotuneHostName(), key);
+
+        const filesystem::path model(modelPath);
+        const filesystem::path directory = config.optimizedModelDir.empty() ? model.parent_path() : filesystem::path(config.optimizedModelDir);
+        const string fileName = model.stem().string() + "." + toHex(key) + (ortFormat ? ".opt.ort" : ".opt.onnx");
+        return (directory / fileName).string();
+    }
+
+    // Decides how to load the model and adjusts sessionOptions accordingly: load the cached graph at cachePath with
+    // optimizations off, or build it from the original model. An empty cachePath (cache off) keeps the original model.
+    static Source prepare(const OrtRuntimeConfig& config, const string& modelPath, const string& cachePath, SessionOptions& sessionOptions)
+    {
+        Source source;
+        source.modelPath = modelPath;
+        if (cachePath.empty())
+            return source;
+        const bool ortFormat = config.optimizedModelCache == OrtRuntimeConfig::OptimizedModelCache::Ort;
+        source.cachePath = cachePath;
+
+        if (filesystem::exists(source.cachePath))
+        {
+            source.modelPath = source.cachePath;
+            sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+            if (ortFormat)
+            {
+                sessionOptions.AddConfigEntry("session.load_model_format", "ORT");
+                if (config.optimizedModelMmap)
+                {
+                    source.mapping = make_shared<MappedFile>();
+                    source.mapping->openReadOnly(source.cachePath);
+                    sessionOptions.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+                    sessionOptions.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+                }
+            }
+            return source;
+        }
+
+        // Written under a temporary name and renamed once the session exists, so a failed start leaves no partial cache.
+        const filesystem::path directory = filesystem::path(source.cachePath).parent_path();
+        if (!directory.empty())
+            filesystem::create_directories(directory);
+        source.pendingPath = source.cachePath + ".tmp";
+        sessionOptions.SetOptimizedModelFilePath(ortPath(source.pendingPath).c_str());
+        if (ortFormat)
+            sessionOptions.AddConfigEntry("session.save_model_format", "ORT");
+        return source;
+    }
+
+    // Creates the session for a prepared source.
+    static shared_ptr<Session> createSession(Env& env, const Source& source, const SessionOptions& sessionOptions)
+    {
+        if (source.mapping)
+            return make_shared<Session>(env, source.mapping->data(), source.mapping->size(), sessionOptions);
+        return make_shared<Session>(env, ortPath(source.modelPath).c_str(), sessionOptions);
+    }
+
+    // Publishes the cache file written while creating the session.
+    static void commit(const Source& source)
+    {
+        if (source.pendingPath.empty() || !filesystem::exists(source.pendingPath))
+            return;
+        error_code error;
+        filesystem::rename(source.pendingPath, source.cachePath, error);
+        if (error)
+            filesystem::remove(source.pendingPath, error);
+    }
+};
+
+#endif // ORT_MODEL_CACHE_H
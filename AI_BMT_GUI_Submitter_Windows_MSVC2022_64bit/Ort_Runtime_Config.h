@@ -0,0 +1,328 @@
+#ifndef ORT_RUNTIME_CONFIG_H
+#define ORT_RUNTIME_CONFIG_H
+
+#include "ai_bmt_file_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Runtime settings shared by the ONNX Runtime example implementations.
+// Values are resolved in this order, later sources overriding earlier ones:
+//   1. Defaults below.
+//   2. Environment variables "AI_BMT_<KEY>" (e.g., AI_BMT_BATCH_SIZE=16), process-wide defaults for every model.
+//   3. "<modelPath>.<host>.autotune", the per-machine profile written by the command-line driver's --autotune.
+//   4. "<modelPath>.cfg" next to the model, one "key=value" per line ('#' starts a comment).
+//   5. Environment variables "AI_BMT_<MODEL STEM>_<KEY>" (e.g., AI_BMT_YOLOV5N_OPSET12_BATCH_SIZE=16), this model only.
+//      The command-line driver sets these for its model with "--set key=value".
+// A model's own files and settings therefore always win over process-wide variables meant for every model.
+// This allows tuning without recompiling the submitter.
+struct OrtRuntimeConfig
+{
+    enum class GraphOptimization { Disabled, Basic, Extended, All };
+    enum class OptimizedModelCache { Off, Onnx, Ort };
+    enum class ResultEncoding { Float32, Float16, Int8 };
+    enum class DetectionLayout { Auto, V5, V8, V10 };
+
+    // Number of queries packed into a single {N, C, H, W} tensor per Session::Run call.
+    // Only used when the model's batch dimension is dynamic; otherwise queries run one at a time.
+    int batchSize = 1;
+
+    // Binds input and output tensors once at Initialize (Ort::IoBinding) and only refreshes
+    // the input contents per query, instead of creating new Ort::Value objects for every Run.
+    bool ioBinding = false;
+
+    // Enables ONNX Runtime session profiling ("<model name>_ort_profile_<date>.json" in the working directory).
+    // The command-line driver turns this on for --trace and merges the profile into its Chrome trace.
+    bool profiling = false;
+
+    // Threads of the intra-op pool (parallelism inside one operator, including the calling thread) and of the
+    // inter-op pool (independent graph branches, parallel execution mode only). 0 keeps ONNX Runtime's default,
+    // one intra-op thread per physical core, which oversubscribes large machines running several sessions.
+    int intraOpThreads = 0;
+    int interOpThreads = 0;
+
+    // "sequential" (default) or "parallel".
+    bool parallelExecution = false;
+
+    // "disabled", "basic", "extended" (default) or "all".
+    GraphOptimization graphOptimization = GraphOptimization::Extended;
+
+    // Idle pool threads busy-wait for the next operator instead of sleeping: lower latency, but they keep
+    // their cores busy between runs. Turn off when sessions or processes share cores.
+    bool allowSpinning = true;
+
+    // CPU affinity of the intra-op pool threads in ONNX Runtime's "session.intra_op_thread_affinities" format:
+    // one group per pool thread (the calling thread is not pinned), groups separated by ';', each a
+    // comma-separated list of logical processors or "first-last" ranges, e.g., "1;2;3" or "1-2;3-4".
+    // intra_op_threads defaults to the number of groups + 1.
+    string threadAffinity;
+
+    // Sessions of the same model run concurrently ("throughput streams"): the batches of a runInference(..) call are
+    // spread over them, so a call needs more than batch_size queries to use more than one session.
+    // Each session costs its own copy of the weights.
+    int sessionCount = 1;
+
+    // With session_count > 1, splits the available cores into one contiguous group per session and pins each
+    // session's worker thread and intra-op pool to its group (intra_op_threads defaults to the group size).
+    // Not applied when thread_affinity is set.
+    bool pinSessions = true;
+
+    // Uses one process-wide Ort::Env with global intra-op/inter-op thread pools for all models instead of per-session
+    // pools, so multi-model runs do not start a pool per model (see Ort_Shared_Env.h). The thread settings above then
+    // size the global pools, taken from the model that creates them (see Ort_Shared_Env.h for re-initialization).
+    bool globalThreadPools = false;
+
+    // Saves the graph-optimized model on the first Initialize and loads it on later starts, skipping graph
+    // optimization (see Ort_Model_Cache.h): "off" (default), "onnx" (optimized ONNX file) or "ort" (ORT format).
+    // Cache files go to optimized_model_dir (default: next to the model) and are keyed by model content,
+    // ONNX Runtime version, graph_optimization and host, so stale files are never loaded.
+    OptimizedModelCache optimizedModelCache = OptimizedModelCache::Off;
+    string optimizedModelDir;
+
+    // ORT-format cache only: memory-maps the cached file and lets ONNX Runtime use its bytes (including the
+    // initializers) in place instead of copying them.
+    bool optimizedModelMmap = true;
+
+    // Object detection only: "raw" (default) returns the model output tensor in objectDetectionResult,
+    // "boxes" decodes it with NMS in the implementation and returns Coco17DetectionResult boxes in
+    // BMTResultExtras::objectDetectionBoxes instead (see Yolo_Postprocess.h and ai_bmt_result_extras.h), a few
+    // hundred boxes instead of 8.5 MB per query. Command-line driver only.
+    bool detectionBoxes = false;
+    float detectionConfThreshold = 0.25f;
+    float detectionIouThreshold = 0.45f;
+
+    // Object detection with detection_output=boxes: output layout of the model, "v5" (rows of box, objectness and
+    // class scores), "v8" (planes of box and class scores) or "v10" (end-to-end rows of box, score and class).
+    // "auto" (default) detects it from the output shape; {N, 6} fits both a single-class YOLOv5 and an end-to-end
+    // model, so it is only read as end-to-end when the model metadata says so ("end2end=True"), and otherwise fails.
+    DetectionLayout detectionLayout = DetectionLayout::Auto;
+
+    // Segmentation only: "raw" (default) returns the logits in segmentationResult, "class_map" reduces them to the
+    // highest-scoring class per pixel in the implementation (see Segmentation_Postprocess.h) and returns that
+    // uint8 map in BMTResultExtras::segmentationClassMap, 1 byte instead of 21 floats per pixel. Command-line driver only.
+    bool segmentationClassMap = false;
+
+    // Detection and segmentation raw outputs: "float32" (default) returns vector<float>; "float16" or "int8" encodes
+    // each output in the implementation (see Result_Encoding.h) and returns it in the *Encoded field of BMTResultExtras,
+    // 2 or 1 byte(s) per value instead of 4. Not used with detection_output=boxes or segmentation_output=class_map.
+    // Command-line driver only.
+    ResultEncoding resultEncoding = ResultEncoding::Float32;
+
+    static vector<string> keys()
+    {
+        return { "batch_size", "io_binding", "profiling", "intra_op_threads", "inter_op_threads", "execution_mode",
+                 "graph_optimization", "allow_spinning", "thread_affinity", "session_count", "pin_sessions",
+                 "global_thread_pools", "optimized_model_cache", "optimized_model_dir", "optimized_model_mmap",
+                 "detection_output", "detection_conf_threshold", "detection_iou_threshold", "detection_layout",
+                 "segmentation_output", "result_encoding" };
+    }
+
+    static bool parseBool(const string& value)
+    {
+        const string lower = toLower(value);
+        if (lower == "1" || lower == "true" || lower == "on" || lower == "yes")
+            return true;
+        if (lower == "0" || lower == "false" || lower == "off" || lower == "no")
+            return false;
+        throw runtime_error("Invalid boolean value: " + value);
+    }
+
+    static string toLower(const string& value)
+    {
+        string lower = value;
+        transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)tolower(c); });
+        return lower;
+    }
+
+    static GraphOptimization parseGraphOptimization(const string& value)
+    {
+        const string lower = toLower(value);
+        if (lower == "disabled" || lower == "disable")
+            return GraphOptimization::Disabled;
+        if (lower == "basic")
+            return GraphOptimization::Basic;
+        if (lower == "extended")
+            return GraphOptimization::Extended;
+        if (lower == "all")
+            return GraphOptimization::All;
+        throw runtime_error("Invalid graph_optimization value (disabled, basic, extended or all): " + value);
+    }
+
+    static OptimizedModelCache parseOptimizedModelCache(const string& value)
+    {
+        const string lower = toLower(value);
+        if (lower == "off" || lower == "0" || lower == "false")
+            return OptimizedModelCache::Off;
+        if (lower == "onnx")
+            return OptimizedModelCache::Onnx;
+        if (lower == "ort")
+            return OptimizedModelCache::Ort;
+        throw runtime_error("Invalid optimized_model_cache value (off, onnx or ort): " + value);
+    }
+
+    static ResultEncoding parseResultEncoding(const string& value)
+    {
+        const string lower = toLower(value);
+        if (lower == "float32" || lower == "fp32")
+            return ResultEncoding::Float32;
+        if (lower == "float16" || lower == "fp16")
+            return ResultEncoding::Float16;
+        if (lower == "int8")
+            return ResultEncoding::Int8;
+        throw runtime_error("Invalid result_encoding value (float32, float16 or int8): " + value);
+    }
+
+    static DetectionLayout parseDetectionLayout(const string& value)
+    {
+        const string lower = toLower(value);
+        if (lower == "auto")
+            return DetectionLayout::Auto;
+        if (lower == "v5")
+            return DetectionLayout::V5;
+        if (lower == "v8")
+            return DetectionLayout::V8;
+        if (lower == "v10")
+            return DetectionLayout::V10;
+        throw runtime_error("Invalid detection_layout value (auto, v5, v8 or v10): " + value);
+    }
+
+    // Number of pinned pool threads described by threadAffinity.
+    size_t affinityGroupCount() const
+    {
+        return threadAffinity.empty() ? 0 : (size_t)count(threadAffinity.begin(), threadAffinity.end(), ';') + 1;
+    }
+
+    // Intra-op thread count to configure, 0 for ONNX Runtime's default.
+    int resolvedIntraOpThreads() const
+    {
+        const size_t groups = affinityGroupCount();
+        if (groups == 0)
+            return intraOpThreads;
+        if (intraOpThreads == 0)
+            return (int)groups + 1;
+        if ((size_t)intraOpThreads != groups + 1)
+            throw runtime_error("thread_affinity has " + to_string(groups) + " group(s), but intra_op_threads=" + to_string(intraOpThreads)
+                + " needs " + to_string(intraOpThreads - 1) + " (one per pool thread besides the calling thread)");
+        return intraOpThreads;
+    }
+
+    void set(const string& key, const string& value)
+    {
+        if (key == "batch_size")
+            batchSize = max(1, stoi(value));
+        else if (key == "io_binding")
+            ioBinding = parseBool(value);
+        else if (key == "profiling")
+            profiling = parseBool(value);
+        else if (key == "intra_op_threads")
+            intraOpThreads = max(0, stoi(value));
+        else if (key == "inter_op_threads")
+            interOpThreads = max(0, stoi(value));
+        else if (key == "execution_mode")
+        {
+            const string mode = toLower(value);
+            if (mode != "sequential" && mode != "parallel")
+                throw runtime_error("Invalid execution_mode value (sequential or parallel): " + value);
+            parallelExecution = mode == "parallel";
+        }
+        else if (key == "graph_optimization")
+            graphOptimization = parseGraphOptimization(value);
+        else if (key == "allow_spinning")
+            allowSpinning = parseBool(value);
+        else if (key == "thread_affinity")
+            threadAffinity = value;
+        else if (key == "session_count")
+            sessionCount = max(1, stoi(value));
+        else if (key == "pin_sessions")
+            pinSessions = parseBool(value);
+        else if (key == "global_thread_pools")
+            globalThreadPools = parseBool(value);
+        else if (key == "optimized_model_cache")
+            optimizedModelCache = parseOptimizedModelCache(value);
+        else if (key == "optimized_model_dir")
+            optimizedModelDir = value;
+        else if (key == "optimized_model_mmap")
+            optimizedModelMmap = parseBool(value);
+        else if (key == "detection_output")
+        {
+            const string output = toLower(value);
+            if (output != "raw" && output != "boxes")
+                throw runtime_error("Invalid detection_output value (raw or boxes): " + value);
+            detectionBoxes = output == "boxes";
+        }
+        else if (key == "detection_conf_threshold")
+            detectionConfThreshold = stof(value);
+        else if (key == "detection_iou_threshold")
+            detectionIouThreshold = stof(value);
+        else if (key == "detection_layout")
+            detectionLayout = parseDetectionLayout(value);
+        else if (key == "segmentation_output")
+        {
+            const string output = toLower(value);
+            if (output != "raw" && output != "class_map")
+                throw runtime_error("Invalid segmentation_output value (raw or class_map): " + value);
+            segmentationClassMap = output == "class_map";
+        }
+        else if (key == "result_encoding")
+            resultEncoding = parseResultEncoding(value);
+        else
+            throw runtime_error("Unknown runtime config key: " + key);
+    }
+
+    static string trim(const string& text)
+    {
+        const char* whitespace = " \t\r\n";
+        size_t begin = text.find_first_not_of(whitespace);
+        if (begin == string::npos)
+            return "";
+        size_t end = text.find_last_not_of(whitespace);
+        return text.substr(begin, end - begin + 1);
+    }
+
+    // Applies "key=value" lines from a config file. Missing files are ignored.
+    void loadFile(const string& path)
+    {
+        ifstream file(path);
+        string line;
+        while (getline(file, line))
+        {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+                continue;
+            size_t separator = line.find('=');
+            if (separator == string::npos)
+                throw runtime_error("Invalid line in " + path + ": " + line);
+            set(trim(line.substr(0, separator)), trim(line.substr(separator + 1)));
+        }
+    }
+
+    // Applies "AI_BMT_<KEY>" variables, or "AI_BMT_<MODEL STEM>_<KEY>" ones for a non-empty modelPath.
+    void loadEnvironment(const string& modelPath = "")
+    {
+        for (const string& key : keys())
+        {
+            const char* value = getenv(settingEnvironmentName(key, modelPath).c_str());
+            if (value != nullptr && *value != '\0')
+                set(key, value);
+        }
+    }
+
+    static OrtRuntimeConfig load(const string& modelPath)
+    {
+        OrtRuntimeConfig config;
+        config.loadEnvironment();
+        config.loadFile(autotuneProfilePath(modelPath));
+        config.loadFile(modelPath + ".cfg");
+        config.loadEnvironment(modelPath);
+        return config;
+    }
+};
+
+#endif // ORT_RUNTIME_CONFIG_H
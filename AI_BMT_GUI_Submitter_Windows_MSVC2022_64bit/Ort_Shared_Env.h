@@ -0,0 +1,89 @@
+#ifndef ORT_SHARED_ENV_H
+#define ORT_SHARED_ENV_H
+
+#include "Ort_Runtime_Config.h"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <onnxruntime_cxx_api.h>
+
+using namespace std;
+using namespace Ort;
+
+// Process-wide Ort::Env shared by every OrtInferenceRunner, so all models of a process (e.g., classification,
+// detection and segmentation in one run) use the same environment.
+// With global_thread_pools=1 the environment owns one intra-op and one inter-op thread pool, sized from the config of
+// the model that creates it (intra_op_threads, inter_op_threads, allow_spinning, thread_affinity), and sessions
+// use these pools (SessionOptions::DisablePerSessionThreads) instead of starting their own.
+// ONNX Runtime fixes the thread pools when the environment is created, so the environment lives only as long as a runner
+// holds it: a model re-initialized alone (e.g., by --autotune) gets a new environment sized from its new settings, while
+// a model that asks for other pools than the ones in use by another model falls back to them with a warning.
+class OrtSharedEnv
+{
+private:
+    struct State
+    {
+        mutex envMutex;
+        weak_ptr<Env> env;
+        bool globalThreadPools = false;
+        string threadPoolSettings; // threadPoolSettings(config) of the model that created env with global pools
+    };
+
+    static State& state()
+    {
+        static State instance;
+        return instance;
+    }
+
+    static string threadPoolSettings(const OrtRuntimeConfig& config)
+    {
+        return "intra_op_threads=" + to_string(config.resolvedIntraOpThreads()) + ", inter_op_threads=" + to_string(config.interOpThreads)
+            + ", allow_spinning=" + to_string(config.allowSpinning ? 1 : 0) + ", thread_affinity=" + config.threadAffinity;
+    }
+
+    static shared_ptr<Env> createWithGlobalThreadPools(const OrtRuntimeConfig& config)
+    {
+        ThreadingOptions threadingOptions;
+        const int intraOpThreads = config.resolvedIntraOpThreads();
+        if (intraOpThreads > 0)
+            threadingOptions.SetGlobalIntraOpNumThreads(intraOpThreads);
+        if (config.interOpThreads > 0)
+            threadingOptions.SetGlobalInterOpNumThreads(config.interOpThreads);
+        threadingOptions.SetGlobalSpinControl(config.allowSpinning ? 1 : 0);
+        if (!config.threadAffinity.empty())
+            ThrowOnError(GetApi().SetGlobalIntraOpThreadAffinity(threadingOptions, config.threadAffinity.c_str()));
+        return make_shared<Env>(threadingOptions, ORT_LOGGING_LEVEL_WARNING, "AI_BMT");
+    }
+
+public:
+    // Returns the shared environment; globalThreadPools tells whether sessions of this config should use its pools.
+    // Callers release their previous environment first, so re-initializing the only model rebuilds the pools.
+    static shared_ptr<Env> acquire(const OrtRuntimeConfig& config, bool& globalThreadPools)
+    {
+        State& shared = state();
+        lock_guard<mutex> lock(shared.envMutex);
+        shared_ptr<Env> env = shared.env.lock();
+        if (!env)
+        {
+            shared.globalThreadPools = config.globalThreadPools;
+            shared.threadPoolSettings = config.globalThreadPools ? threadPoolSettings(config) : "";
+            env = config.globalThreadPools ? createWithGlobalThreadPools(config) : make_shared<Env>(ORT_LOGGING_LEVEL_WARNING, "AI_BMT");
+            shared.env = env;
+        }
+        else if (config.globalThreadPools && !shared.globalThreadPools)
+        {
+            cerr << "Warning: global_thread_pools requested after the ONNX Runtime environment was created without them; "
+                 << "using per-session threads" << endl;
+        }
+        else if (config.globalThreadPools && threadPoolSettings(config) != shared.threadPoolSettings)
+        {
+            cerr << "Warning: the global thread pools in use by another model keep " << shared.threadPoolSettings
+                 << "; ignoring " << threadPoolSettings(config) << endl;
+        }
+        globalThreadPools = config.globalThreadPools && shared.globalThreadPools;
+        return env;
+    }
+};
+
+#endif // ORT_SHARED_ENV_H
@@ -0,0 +1,136 @@
+#ifndef ORT_TENSOR_HELPER_H
+#define ORT_TENSOR_HELPER_H
+
+#include "ai_bmt_interface.h"
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include <onnxruntime_cxx_api.h>
+
+using namespace std;
+
+// Read-only view of the memory held by one VariantType query.
+// No data is copied; the view is valid as long as the VariantType it was made from.
+struct OrtInputView
+{
+    const void* data = nullptr;
+    size_t elementCount = 0;
+    size_t elementSize = 0;
+    ONNXTensorElementDataType elementType = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    const vector<int64_t>* shape = nullptr; // Query shape of a TensorView input; null for vector<T>/T*
+
+    size_t byteCount() const { return elementCount * elementSize; }
+};
+
+#ifdef AI_BMT_CLI_BUILD
+inline ONNXTensorElementDataType toOnnxElementType(TensorDataType type)
+{
+    switch (type)
+    {
+    case TensorDataType::UInt8: return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+    case TensorDataType::UInt16: return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16;
+    case TensorDataType::UInt32: return ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32;
+    case TensorDataType::Int8: return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    case TensorDataType::Int16: return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16;
+    case TensorDataType::Int32: return ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32;
+    case TensorDataType::Float16: return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16;
+    default: return ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    }
+}
+#endif
+
+template <typename T>
+struct IsStdVector : false_type {};
+
+template <typename T>
+struct IsStdVector<vector<T>> : true_type {};
+
+// Creates a view over vector<T>, T* or TensorView alternatives of VariantType.
+// Raw pointers carry no size, so expectedElementCount is used for them; vectors and tensor views are checked against it.
+// Tensor views must be contiguous, since ONNX Runtime binds them in place.
+inline OrtInputView makeInputView(const VariantType& data, size_t expectedElementCount)
+{
+    return visit([expectedElementCount](const auto& value) -> OrtInputView {
+        using ValueType = decay_t<decltype(value)>;
+        OrtInputView view;
+        if constexpr (IsStdVector<ValueType>::value)
+        {
+            using ElementType = typename ValueType::value_type;
+            if (value.size() != expectedElementCount)
+                throw runtime_error("Input has " + to_string(value.size()) + " elements, expected " + to_string(expectedElementCount));
+            view.data = value.data();
+            view.elementCount = value.size();
+            view.elementSize = sizeof(ElementType);
+            view.elementType = Ort::TypeToTensorType<ElementType>::type;
+        }
+#ifdef AI_BMT_CLI_BUILD
+        else if constexpr (is_same_v<ValueType, TensorView>)
+        {
+            if (value.data == nullptr)
+                throw runtime_error("TensorView data is null");
+            if (!value.isContiguous())
+                throw runtime_error("TensorView is strided; ONNX Runtime needs contiguous input");
+            if (value.elementCount() != expectedElementCount)
+                throw runtime_error("Input has " + to_string(value.elementCount()) + " elements, expected " + to_string(expectedElementCount));
+            view.data = value.data;
+            view.elementCount = value.elementCount();
+            view.elementSize = TensorView::elementSize(value.dtype);
+            view.elementType = toOnnxElementType(value.dtype);
+            view.shape = &value.shape;
+        }
+#endif
+        else if constexpr (is_pointer_v<ValueType> && !is_void_v<remove_pointer_t<ValueType>>)
+        {
+            using ElementType = remove_pointer_t<ValueType>;
+            if (value == nullptr)
+                throw runtime_error("Input pointer is null");
+            view.data = value;
+            view.elementCount = expectedElementCount;
+            view.elementSize = sizeof(ElementType);
+            view.elementType = Ort::TypeToTensorType<ElementType>::type;
+        }
+        else
+        {
+            throw runtime_error("Unsupported input type for ONNX Runtime (PythonObject)");
+        }
+        return view;
+    }, data);
+}
+
+// Size in bytes of one element of the given ONNX tensor type.
+inline size_t tensorElementSize(ONNXTensorElementDataType type)
+{
+    switch (type)
+    {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+        return 1;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+        return 2;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        return 4;
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        return 8;
+    default:
+        throw runtime_error("Unsupported ONNX tensor element type: " + to_string(type));
+    }
+}
+
+// Binds an Ort::Value directly onto the memory of the view (zero-copy).
+// ONNX Runtime only reads input tensors, so dropping const here is safe.
+inline Ort::Value createInputTensor(const Ort::MemoryInfo& memoryInfo, const OrtInputView& view, const int64_t* shape, size_t shapeLength)
+{
+    return Ort::Value::CreateTensor(memoryInfo, const_cast<void*>(view.data), view.byteCount(), shape, shapeLength, view.elementType);
+}
+
+#endif // ORT_TENSOR_HELPER_H
@@ -0,0 +1,60 @@
+#ifndef OUTPUT_BUFFER_POOL_H
+#define OUTPUT_BUFFER_POOL_H
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Recycles fixed-size output buffers so that runInference(..) does not allocate (and zero-fill)
+// a new vector<float> per query. Buffers are moved into BMTResult and come back through
+// AI_BMT_Interface::releaseResults(..) once the caller is done with them.
+template <typename T>
+class OutputBufferPool
+{
+private:
+    mutex poolMutex;
+    vector<vector<T>> freeBuffers;
+    size_t bufferSize = 0;
+
+public:
+    // Drops all pooled buffers and preallocates `count` buffers of `elementCount` elements.
+    void reset(size_t elementCount, size_t count)
+    {
+        lock_guard<mutex> lock(poolMutex);
+        bufferSize = elementCount;
+        freeBuffers.clear();
+        freeBuffers.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            freeBuffers.emplace_back(bufferSize);
+    }
+
+    size_t elementCount() const { return bufferSize; }
+
+    // Returns a buffer of elementCount() elements. Its contents are unspecified.
+    vector<T> acquire()
+    {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            if (!freeBuffers.empty())
+            {
+                vector<T> buffer = move(freeBuffers.back());
+                freeBuffers.pop_back();
+                return buffer;
+            }
+        }
+        return vector<T>(bufferSize);
+    }
+
+    // Gives a buffer back to the pool. Buffers of another size (e.g., from before a reset) are discarded.
+    void release(vector<T>&& buffer)
+    {
+        if (buffer.size() != bufferSize)
+            return;
+        lock_guard<mutex> lock(poolMutex);
+        freeBuffers.push_back(move(buffer));
+    }
+};
+
+#endif // OUTPUT_BUFFER_POOL_H
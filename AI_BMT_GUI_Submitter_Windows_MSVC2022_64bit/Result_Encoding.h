@@ -0,0 +1,176 @@
+#ifndef RESULT_ENCODING_H
+#define RESULT_ENCODING_H
+
+#include "ai_bmt_encoded_tensor.h"
+#include "Image_Preprocessing.h"
+#include "Output_Buffer_Pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <onnxruntime_cxx_api.h>
+
+using namespace std;
+
+namespace result_encoding_detail
+{
+    inline void toFloat16Scalar(const float* input, size_t begin, size_t end, uint16_t* output)
+    {
+        for (size_t i = begin; i < end; ++i)
+            output[i] = Ort::Float16_t(input[i]).val;
+    }
+
+    inline void toInt8Scalar(const float* input, size_t begin, size_t end, float inverseScale, int32_t zeroPoint, int8_t* output)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const long value = lrintf(input[i] * inverseScale) + zeroPoint;
+            output[i] = (int8_t)min(127L, max(-128L, value));
+        }
+    }
+
+#ifdef IMAGE_PREPROCESSING_X86
+    // F16C conversion of 8 floats per instruction, round to nearest even like Ort::Float16_t
+    // (every CPU with AVX2 also has F16C).
+    IMAGE_PREPROCESSING_TARGET("avx2,f16c")
+    inline void toFloat16Avx2(const float* input, size_t count, uint16_t* output)
+    {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128((__m128i*)(output + i), half);
+        }
+        toFloat16Scalar(input, i, count, output);
+    }
+
+    IMAGE_PREPROCESSING_TARGET("avx2")
+    inline void toInt8Avx2(const float* input, size_t count, float inverseScale, int32_t zeroPoint, int8_t* output)
+    {
+        const __m256 multiplier = _mm256_set1_ps(inverseScale);
+        const __m256i offset = _mm256_set1_epi32(zeroPoint);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256i value = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(input + i), multiplier)), offset);
+            // 8 x int32 -> 8 x int8 with signed saturation
+            const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+            _mm_storel_epi64((__m128i*)(output + i), _mm_packs_epi16(words, words));
+        }
+        toInt8Scalar(input, i, count, inverseScale, zeroPoint, output);
+    }
+
+    IMAGE_PREPROCESSING_TARGET("avx2")
+    inline void minMaxAvx2(const float* input, size_t count, float& minimum, float& maximum)
+    {
+        __m256 low = _mm256_set1_ps(minimum);
+        __m256 high = _mm256_set1_ps(maximum);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 value = _mm256_loadu_ps(input + i);
+            low = _mm256_min_ps(low, value);
+            high = _mm256_max_ps(high, value);
+        }
+        alignas(32) float lows[8];
+        alignas(32) float highs[8];
+        _mm256_store_ps(lows, low);
+        _mm256_store_ps(highs, high);
+        minimum = *min_element(lows, lows + 8);
+        maximum = *max_element(highs, highs + 8);
+        for (; i < count; ++i)
+        {
+            minimum = min(minimum, input[i]);
+            maximum = max(maximum, input[i]);
+        }
+    }
+#endif
+}
+
+// Encodes float outputs into EncodedTensor (result_encoding=float16|int8, see Ort_Runtime_Config.h), reusing the
+// encoded buffers returned through recycle(..). Int8 uses one asymmetric scale/zero point per tensor, taken from its
+// min/max. encode(..) and recycle(..) may be called from several session workers at once.
+class ResultEncoder
+{
+private:
+    EncodedTensor::Encoding encoding = EncodedTensor::Encoding::Float16;
+    PreprocessingSimdLevel level = preprocessingSimdLevel();
+    OutputBufferPool<uint16_t> float16Pool;
+    OutputBufferPool<int8_t> int8Pool;
+
+    // Range of the tensor extended to include 0.
+    void minMax(const float* input, size_t count, float& minimum, float& maximum) const
+    {
+        minimum = 0;
+        maximum = 0;
+#ifdef IMAGE_PREPROCESSING_X86
+        if (level != PreprocessingSimdLevel::Scalar)
+        {
+            result_encoding_detail::minMaxAvx2(input, count, minimum, maximum);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i)
+        {
+            minimum = min(minimum, input[i]);
+            maximum = max(maximum, input[i]);
+        }
+    }
+
+public:
+    // Preallocates `count` buffers of `elementCount` elements for the given encoding.
+    void reset(EncodedTensor::Encoding encoding, size_t elementCount, size_t count,
+        PreprocessingSimdLevel level = preprocessingSimdLevel())
+    {
+        this->encoding = encoding;
+        this->level = level;
+        const bool float16 = encoding == EncodedTensor::Encoding::Float16;
+        float16Pool.reset(elementCount, float16 ? count : 0);
+        int8Pool.reset(elementCount, float16 ? 0 : count);
+    }
+
+    void encode(const float* input, size_t count, EncodedTensor& output)
+    {
+        output.encoding = encoding;
+        if (encoding == EncodedTensor::Encoding::Float16)
+        {
+            output.float16Data = float16Pool.acquire();
+            output.float16Data.resize(count);
+#ifdef IMAGE_PREPROCESSING_X86
+            if (level != PreprocessingSimdLevel::Scalar)
+            {
+                result_encoding_detail::toFloat16Avx2(input, count, output.float16Data.data());
+                return;
+            }
+#endif
+            result_encoding_detail::toFloat16Scalar(input, 0, count, output.float16Data.data());
+            return;
+        }
+
+        // The range always includes 0, so 0 is exact and all-zero tensors get a valid scale.
+        float minimum;
+        float maximum;
+        minMax(input, count, minimum, maximum);
+        output.scale = maximum > minimum ? (maximum - minimum) / 255.0f : 1.0f;
+        output.zeroPoint = (int32_t)lrintf(-128.0f - minimum / output.scale);
+        output.int8Data = int8Pool.acquire();
+        output.int8Data.resize(count);
+        const float inverseScale = 1.0f / output.scale;
+#ifdef IMAGE_PREPROCESSING_X86
+        if (level != PreprocessingSimdLevel::Scalar)
+        {
+            result_encoding_detail::toInt8Avx2(input, count, inverseScale, output.zeroPoint, output.int8Data.data());
+            return;
+        }
+#endif
+        result_encoding_detail::toInt8Scalar(input, 0, count, inverseScale, output.zeroPoint, output.int8Data.data());
+    }
+
+    void recycle(EncodedTensor&& tensor)
+    {
+        float16Pool.release(move(tensor.float16Data));
+        int8Pool.release(move(tensor.int8Data));
+    }
+};
+
+#endif // RESULT_ENCODING_H
@@ -0,0 +1,79 @@
+#ifndef SEGMENTATION_POSTPROCESS_H
+#define SEGMENTATION_POSTPROCESS_H
+
+#include "Image_Preprocessing.h"
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace segmentation_postprocess_detail
+{
+    // Pixels [begin, end) of the class map (scalar reference and tail of the AVX2 kernel).
+    inline void argmaxScalar(const float* logits, size_t channels, size_t planeSize, size_t begin, size_t end, uint8_t* classMap)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint8_t best = 0;
+            float bestScore = logits[i];
+            for (size_t c = 1; c < channels; ++c)
+            {
+                const float score = logits[c * planeSize + i];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = (uint8_t)c;
+                }
+            }
+            classMap[i] = best;
+        }
+    }
+
+#ifdef IMAGE_PREPROCESSING_X86
+    // Running max/argmax of 8 pixels at a time over the channel planes: every load is a contiguous row of one
+    // plane, so the CHW logits are read once in order and never transposed.
+    IMAGE_PREPROCESSING_TARGET("avx2")
+    inline void argmaxAvx2(const float* logits, size_t channels, size_t planeSize, uint8_t* classMap)
+    {
+        size_t i = 0;
+        for (; i + 8 <= planeSize; i += 8)
+        {
+            __m256 bestScore = _mm256_loadu_ps(logits + i);
+            __m256i best = _mm256_setzero_si256();
+            for (size_t c = 1; c < channels; ++c)
+            {
+                const __m256 score = _mm256_loadu_ps(logits + c * planeSize + i);
+                const __m256 greater = _mm256_cmp_ps(score, bestScore, _CMP_GT_OQ);
+                bestScore = _mm256_blendv_ps(bestScore, score, greater);
+                best = _mm256_blendv_epi8(best, _mm256_set1_epi32((int)c), _mm256_castps_si256(greater));
+            }
+            // 8 x int32 -> 8 x uint8
+            const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+            _mm_storel_epi64((__m128i*)(classMap + i), _mm_packus_epi16(words, words));
+        }
+        argmaxScalar(logits, channels, planeSize, i, planeSize, classMap);
+    }
+#endif
+}
+
+// Reduces (Channel, Height, Width) logits to a (Height, Width) map of the highest-scoring class per pixel,
+// e.g., 21 x 520 x 520 floats (22.7 MB) to 520 x 520 bytes (270 KB). Ties keep the lower class index.
+// `classMap` must hold planeSize (Height * Width) bytes; at most 256 classes.
+inline void argmaxToClassMap(const float* logits, size_t channels, size_t planeSize, uint8_t* classMap,
+    PreprocessingSimdLevel level = preprocessingSimdLevel())
+{
+    if (channels == 0 || channels > 256)
+        throw runtime_error("Class map supports 1 to 256 classes, got " + to_string(channels));
+#ifdef IMAGE_PREPROCESSING_X86
+    if (level != PreprocessingSimdLevel::Scalar)
+    {
+        segmentation_postprocess_detail::argmaxAvx2(logits, channels, planeSize, classMap);
+        return;
+    }
+#endif
+    segmentation_postprocess_detail::argmaxScalar(logits, channels, planeSize, 0, planeSize, classMap);
+}
+
+#endif // SEGMENTATION_POSTPROCESS_H
@@ -0,0 +1,347 @@
+#ifndef YOLO_POSTPROCESS_H
+#define YOLO_POSTPROCESS_H
+
+#include "Image_Preprocessing.h"
+#include "label_type.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Output layouts of the YOLO generations benchmarked with the object detection example (shapes without batch):
+//   RowMajor      YOLOv5: {candidates, 5 + classes}, rows of [cx, cy, w, h, objectness, class scores...], e.g., {25200, 85}
+//   ChannelMajor  YOLOv5u/v8/v9/11/12: {4 + classes, candidates}, planes of cx, cy, w, h and class scores, e.g., {84, 8400}
+//   EndToEnd      YOLOv10: {detections, 6}, rows of [x1, y1, x2, y2, score, class] already suppressed by the model
+enum class YoloOutputLayout
+{
+    RowMajor,
+    ChannelMajor,
+    EndToEnd
+};
+
+struct YoloOutputFormat
+{
+    YoloOutputLayout layout = YoloOutputLayout::RowMajor;
+    size_t candidates = 0;
+    size_t classes = 0;
+
+    // Detects the layout from the output shape of one query (e.g., OrtInferenceRunner::outputShape()).
+    // Candidates always outnumber the values per candidate, which tells rows from planes. {N, 6} is either a
+    // single-class YOLOv5 or an end-to-end model; it is only read as end-to-end when endToEndModel says so
+    // (e.g., from the model metadata), and is otherwise rejected instead of guessed.
+    static YoloOutputFormat fromShape(const vector<int64_t>& shape, bool endToEndModel = false)
+    {
+        const size_t rows = checkedDimension(shape, 0);
+        const size_t columns = checkedDimension(shape, 1);
+        if (endToEndModel)
+            return withLayout(shape, YoloOutputLayout::EndToEnd);
+        if (columns == 6 && rows > columns)
+            throw runtime_error("Ambiguous YOLO output shape " + shapeText(shape)
+                + ": a single-class YOLOv5 or an end-to-end (YOLOv10) model; set detection_layout=v5 or v10");
+        if (rows > columns && columns > 5)
+            return withLayout(shape, YoloOutputLayout::RowMajor);
+        if (columns > rows && rows > 4)
+            return withLayout(shape, YoloOutputLayout::ChannelMajor);
+        throw runtime_error("Unsupported YOLO output shape " + shapeText(shape));
+    }
+
+    // Uses the given layout (detection_layout=v5, v8 or v10) and checks that the shape fits it.
+    static YoloOutputFormat withLayout(const vector<int64_t>& shape, YoloOutputLayout layout)
+    {
+        const size_t rows = checkedDimension(shape, 0);
+        const size_t columns = checkedDimension(shape, 1);
+        YoloOutputFormat format;
+        format.layout = layout;
+        bool fits = false;
+        switch (layout)
+        {
+        case YoloOutputLayout::RowMajor:
+            fits = columns > 5;
+            format.candidates = rows;
+            format.classes = columns - 5;
+            break;
+        case YoloOutputLayout::ChannelMajor:
+            fits = rows > 4;
+            format.candidates = columns;
+            format.classes = rows - 4;
+            break;
+        case YoloOutputLayout::EndToEnd:
+            fits = columns == 6;
+            format.candidates = rows;
+            break;
+        }
+        if (!fits)
+            throw runtime_error("YOLO output shape " + shapeText(shape) + " does not match the " + format.name() + " layout");
+        return format;
+    }
+
+    const char* name() const
+    {
+        switch (layout)
+        {
+        case YoloOutputLayout::ChannelMajor: return "channel-major (YOLOv8 family)";
+        case YoloOutputLayout::EndToEnd: return "end-to-end (YOLOv10)";
+        default: return "row-major (YOLOv5)";
+        }
+    }
+
+private:
+    static size_t checkedDimension(const vector<int64_t>& shape, size_t index)
+    {
+        if (shape.size() != 2 || shape[index] <= 0)
+            throw runtime_error("Unsupported YOLO output shape: expected 2 dimensions besides the batch dimension");
+        return (size_t)shape[index];
+    }
+
+    static string shapeText(const vector<int64_t>& shape)
+    {
+        return "{" + to_string(shape[0]) + ", " + to_string(shape[1]) + "}";
+    }
+};
+
+// Thresholds of the compact detection path (detection_output=boxes, see Ort_Runtime_Config.h).
+// Defaults follow the usual YOLOv5 evaluation settings.
+struct YoloDecodeSettings
+{
+    float confThreshold = 0.25f;  // Minimum objectness * class score
+    float iouThreshold = 0.45f;   // Boxes of the same class overlapping more than this are suppressed
+    size_t maxDetections = 300;   // Kept after NMS, highest confidence first
+    size_t maxCandidates = 30000; // Entering NMS, highest confidence first
+    bool classAgnostic = false;   // Suppress overlapping boxes across classes
+};
+
+namespace yolo_postprocess_detail
+{
+    // Indices of candidates whose objectness exceeds the threshold. Since confidence = objectness * class score
+    // and scores are in [0, 1], no other candidate can pass confThreshold, so the full class argmax only runs
+    // on the few hundred survivors instead of all 25200 rows.
+    inline void filterObjectnessScalar(const float* data, size_t candidates, size_t stride, float threshold, vector<uint32_t>& survivors)
+    {
+        for (size_t i = 0; i < candidates; ++i)
+        {
+            if (data[i * stride + 4] > threshold)
+                survivors.push_back((uint32_t)i);
+        }
+    }
+
+#ifdef IMAGE_PREPROCESSING_X86
+    // Gathers the objectness of 8 rows per step (stride apart) and compares them in one instruction.
+    IMAGE_PREPROCESSING_TARGET("avx2")
+    inline void filterObjectnessAvx2(const float* data, size_t candidates, size_t stride, float threshold, vector<uint32_t>& survivors)
+    {
+        const __m256 limit = _mm256_set1_ps(threshold);
+        const int step = (int)stride;
+        const __m256i offsets = _mm256_setr_epi32(0, step, 2 * step, 3 * step, 4 * step, 5 * step, 6 * step, 7 * step);
+        size_t i = 0;
+        for (; i + 8 <= candidates; i += 8)
+        {
+            const __m256 objectness = _mm256_i32gather_ps(data + i * stride + 4, offsets, 4);
+            unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(objectness, limit, _CMP_GT_OQ));
+            while (mask != 0)
+            {
+                unsigned lane = 0;
+                while ((mask & (1u << lane)) == 0)
+                    ++lane;
+                survivors.push_back((uint32_t)(i + lane));
+                mask &= mask - 1;
+            }
+        }
+        const size_t tail = survivors.size();
+        filterObjectnessScalar(data + i * stride, candidates - i, stride, threshold, survivors);
+        for (size_t k = tail; k < survivors.size(); ++k)
+            survivors[k] += (uint32_t)i;
+    }
+#endif
+
+    inline float intersectionOverUnion(const Coco17DetectionResult& a, const Coco17DetectionResult& b)
+    {
+        const float left = max(a.top_left_x, b.top_left_x);
+        const float top = max(a.top_left_y, b.top_left_y);
+        const float right = min(a.top_left_x + a.width, b.top_left_x + b.width);
+        const float bottom = min(a.top_left_y + a.height, b.top_left_y + b.height);
+        if (right <= left || bottom <= top)
+            return 0.0f;
+        const float intersection = (right - left) * (bottom - top);
+        const float unionArea = a.width * a.height + b.width * b.height - intersection;
+        return unionArea > 0 ? intersection / unionArea : 0.0f;
+    }
+
+    // Channel-major candidates [begin, end): best class per candidate (scalar reference and tail of the AVX2 kernel).
+    // Candidates whose best score exceeds the threshold are appended as boxes.
+    inline void decodeChannelMajorScalar(const float* data, size_t candidates, size_t classes, size_t begin, size_t end,
+        float threshold, vector<Coco17DetectionResult>& detections)
+    {
+        const float* scores = data + 4 * candidates;
+        for (size_t i = begin; i < end; ++i)
+        {
+            size_t best = 0;
+            float bestScore = scores[i];
+            for (size_t c = 1; c < classes; ++c)
+            {
+                const float score = scores[c * candidates + i];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = c;
+                }
+            }
+            if (bestScore <= threshold)
+                continue;
+            const float w = data[2 * candidates + i];
+            const float h = data[3 * candidates + i];
+            detections.emplace_back((int)best, data[i] - w / 2, data[candidates + i] - h / 2, w, h, bestScore);
+        }
+    }
+
+#ifdef IMAGE_PREPROCESSING_X86
+    // Running max/argmax of 8 candidates at a time over the class planes, i.e., the argmax of the transposed
+    // matrix without transposing it.
+    IMAGE_PREPROCESSING_TARGET("avx2")
+    inline void decodeChannelMajorAvx2(const float* data, size_t candidates, size_t classes, float threshold,
+        vector<Coco17DetectionResult>& detections)
+    {
+        const float* scores = data + 4 * candidates;
+        const __m256 limit = _mm256_set1_ps(threshold);
+        size_t i = 0;
+        for (; i + 8 <= candidates; i += 8)
+        {
+            __m256 bestScore = _mm256_loadu_ps(scores + i);
+            __m256 best = _mm256_setzero_ps();
+            for (size_t c = 1; c < classes; ++c)
+            {
+                const __m256 score = _mm256_loadu_ps(scores + c * candidates + i);
+                const __m256 greater = _mm256_cmp_ps(score, bestScore, _CMP_GT_OQ);
+                bestScore = _mm256_blendv_ps(bestScore, score, greater);
+                best = _mm256_blendv_ps(best, _mm256_set1_ps((float)c), greater);
+            }
+            unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(bestScore, limit, _CMP_GT_OQ));
+            if (mask == 0)
+                continue;
+            alignas(32) float laneScore[8];
+            alignas(32) float laneClass[8];
+            _mm256_store_ps(laneScore, bestScore);
+            _mm256_store_ps(laneClass, best);
+            while (mask != 0)
+            {
+                unsigned lane = 0;
+                while ((mask & (1u << lane)) == 0)
+                    ++lane;
+                mask &= mask - 1;
+                const size_t k = i + lane;
+                const float w = data[2 * candidates + k];
+                const float h = data[3 * candidates + k];
+                detections.emplace_back((int)laneClass[lane], data[k] - w / 2, data[candidates + k] - h / 2, w, h, laneScore[lane]);
+            }
+        }
+        decodeChannelMajorScalar(data, candidates, classes, i, candidates, threshold, detections);
+    }
+#endif
+}
+
+// Greedy NMS in place: sorts by confidence and drops every box overlapping a kept box of the same class
+// (any class with classAgnostic) by more than iouThreshold.
+inline void suppressOverlappingDetections(vector<Coco17DetectionResult>& detections, const YoloDecodeSettings& settings)
+{
+    sort(detections.begin(), detections.end(),
+        [](const Coco17DetectionResult& a, const Coco17DetectionResult& b) { return a.confidence > b.confidence; });
+    if (detections.size() > settings.maxCandidates)
+        detections.resize(settings.maxCandidates);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < detections.size() && kept < settings.maxDetections; ++i)
+    {
+        bool suppressed = false;
+        for (size_t k = 0; k < kept && !suppressed; ++k)
+        {
+            if (!settings.classAgnostic && detections[k].classIndex != detections[i].classIndex)
+                continue;
+            suppressed = yolo_postprocess_detail::intersectionOverUnion(detections[k], detections[i]) > settings.iouThreshold;
+        }
+        if (!suppressed)
+            detections[kept++] = detections[i];
+    }
+    detections.resize(kept);
+}
+
+// Decodes a YOLOv5-style output of `candidates` rows, each [cx, cy, w, h, objectness, class scores...]
+// (stride = 5 + class count), into boxes after NMS. Boxes are top-left/width/height in model-input pixels
+// (e.g., the 640x640 padded image), the same space as the raw output.
+inline vector<Coco17DetectionResult> decodeYoloV5(const float* data, size_t candidates, size_t stride,
+    const YoloDecodeSettings& settings = YoloDecodeSettings(),
+    PreprocessingSimdLevel level = preprocessingSimdLevel())
+{
+    vector<uint32_t> survivors;
+#ifdef IMAGE_PREPROCESSING_X86
+    if (level != PreprocessingSimdLevel::Scalar && candidates * stride < (size_t)INT32_MAX)
+        yolo_postprocess_detail::filterObjectnessAvx2(data, candidates, stride, settings.confThreshold, survivors);
+    else
+#endif
+        yolo_postprocess_detail::filterObjectnessScalar(data, candidates, stride, settings.confThreshold, survivors);
+
+    vector<Coco17DetectionResult> detections;
+    detections.reserve(survivors.size());
+    for (uint32_t index : survivors)
+    {
+        const float* row = data + (size_t)index * stride;
+        const float* scores = row + 5;
+        const size_t best = (size_t)(max_element(scores, row + stride) - scores);
+        const float confidence = row[4] * scores[best];
+        if (confidence <= settings.confThreshold)
+            continue;
+        detections.emplace_back((int)best, row[0] - row[2] / 2, row[1] - row[3] / 2, row[2], row[3], confidence);
+    }
+    suppressOverlappingDetections(detections, settings);
+    return detections;
+}
+
+// Decodes a YOLOv8-style channel-major output ({4 + classes, candidates}, no objectness) into boxes after NMS,
+// reading the planes in place instead of transposing them to rows first.
+inline vector<Coco17DetectionResult> decodeYoloV8(const float* data, size_t candidates, size_t classes,
+    const YoloDecodeSettings& settings = YoloDecodeSettings(),
+    PreprocessingSimdLevel level = preprocessingSimdLevel())
+{
+    vector<Coco17DetectionResult> detections;
+    if (classes == 0)
+        return detections;
+#ifdef IMAGE_PREPROCESSING_X86
+    if (level != PreprocessingSimdLevel::Scalar)
+        yolo_postprocess_detail::decodeChannelMajorAvx2(data, candidates, classes, settings.confThreshold, detections);
+    else
+#endif
+        yolo_postprocess_detail::decodeChannelMajorScalar(data, candidates, classes, 0, candidates, settings.confThreshold, detections);
+    suppressOverlappingDetections(detections, settings);
+    return detections;
+}
+
+// Converts a YOLOv10 end-to-end output ({detections, 6} of [x1, y1, x2, y2, score, class]); the model already
+// suppressed duplicates, so this only applies the confidence threshold and maxDetections.
+inline vector<Coco17DetectionResult> decodeYoloV10(const float* data, size_t rows, const YoloDecodeSettings& settings = YoloDecodeSettings())
+{
+    vector<Coco17DetectionResult> detections;
+    for (size_t i = 0; i < rows && detections.size() < settings.maxDetections; ++i)
+    {
+        const float* row = data + i * 6;
+        if (row[4] <= settings.confThreshold)
+            continue;
+        detections.emplace_back((int)row[5], row[0], row[1], row[2] - row[0], row[3] - row[1], row[4]);
+    }
+    return detections;
+}
+
+// Decodes one query's output in the given layout.
+inline vector<Coco17DetectionResult> decodeYolo(const float* data, const YoloOutputFormat& format,
+    const YoloDecodeSettings& settings = YoloDecodeSettings(),
+    PreprocessingSimdLevel level = preprocessingSimdLevel())
+{
+    switch (format.layout)
+    {
+    case YoloOutputLayout::ChannelMajor: return decodeYoloV8(data, format.candidates, format.classes, settings, level);
+    case YoloOutputLayout::EndToEnd: return decodeYoloV10(data, format.candidates, settings);
+    default: return decodeYoloV5(data, format.candidates, format.classes + 5, settings, level);
+    }
+}
+
+#endif // YOLO_POSTPROCESS_H
@@ -1,5 +1,11 @@
 ﻿#include "ai_bmt_gui_caller.h"
+#include "ai_bmt_cli_caller.h"
+#include "Image_Preprocessing.h"
+#include "Ort_Inference_Runner.h"
+#include "Result_Encoding.h"
+#include "Segmentation_Postprocess.h"
 #include "ai_bmt_interface.h"
+#include "ai_bmt_result_extras.h"
 #include <thread>
 #include <chrono>
 #include <iostream>
@@ -25,34 +31,49 @@ using namespace Ort;
 using BMTDataType = vector<float>;
 
 // To view detailed information on what and how to implement for "AI_BMT_Interface," navigate to its definition (e.g., in Visual Studio/VSCode: Press F12).
-class ImageSegmentation_Interface_Implementation : public AI_BMT_Interface
+// segmentation_output=class_map and result_encoding=float16|int8 keep their outputs in a side table (ai_bmt_result_extras.h), which the
+// command-line driver reports and checks against raw results (--check-results).
+class ImageSegmentation_Interface_Implementation : public AI_BMT_Interface, public BMTResultExtrasProvider
 {
 private:
-    Env env;
-    RunOptions runOptions;
-    shared_ptr<Session> session;
-    array<const char*, 1> inputNames;
-    array<const char*, 1> outputNames;
-    MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    OrtInferenceRunner runner;
+    bool encodeOutput = false; // result_encoding=float16|int8
+    ResultEncoder encoder;
+    bool classMapOutput = false; // segmentation_output=class_map
+    size_t classCount = 0;
+    size_t planeSize = 0;
+    OutputBufferPool<uint8_t> classMapPool;
+    BMTResultExtrasTable extras;
+
+    void recycleExtras(BMTResultExtras& resultExtras)
+    {
+        encoder.recycle(move(resultExtras.segmentationResultEncoded));
+        classMapPool.release(move(resultExtras.segmentationClassMap));
+    }
 
 public:
     virtual void Initialize(string modelPath) override
     {
-        //session initializer
-        SessionOptions sessionOptions;
-        sessionOptions.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-        wstring modelPathwstr(modelPath.begin(), modelPath.end());
-        session = make_shared<Session>(env, modelPathwstr.c_str(), sessionOptions);
-
-        // Get input and output names
-        AllocatorWithDefaultOptions allocator;
-        AllocatedStringPtr inputName = session->GetInputNameAllocated(0, allocator);
-        AllocatedStringPtr outputName = session->GetOutputNameAllocated(0, allocator);
-        inputNames = { inputName.get() };
-        outputNames = { outputName.get() };
-        inputName.release();
-        outputName.release();
+        // Input shape of a single query, used where the model leaves an input dimension dynamic.
+        // Batching is enabled automatically when the model's batch dimension is dynamic (see Ort_Runtime_Config.h for batch_size).
+        runner.initialize(modelPath, { 3, 520, 520 });
+
+        classMapOutput = runner.runtimeConfig().segmentationClassMap;
+        if (classMapOutput)
+            requireResultExtras("segmentation_output=class_map");
+        const vector<int64_t>& outputShape = runner.outputShape();
+        classCount = (size_t)outputShape.front();
+        planeSize = 1;
+        for (size_t i = 1; i < outputShape.size(); ++i)
+            planeSize *= (size_t)outputShape[i];
+        classMapPool.reset(planeSize, classMapOutput ? (size_t)runner.batchSize() * runner.sessionCount() : 0);
+
+        const OrtRuntimeConfig::ResultEncoding resultEncoding = runner.runtimeConfig().resultEncoding;
+        encodeOutput = !classMapOutput && resultEncoding != OrtRuntimeConfig::ResultEncoding::Float32;
+        if (encodeOutput)
+            requireResultExtras("result_encoding");
+        encoder.reset(resultEncoding == OrtRuntimeConfig::ResultEncoding::Int8 ? EncodedTensor::Encoding::Int8 : EncodedTensor::Encoding::Float16,
+            classCount * planeSize, encodeOutput ? (size_t)runner.batchSize() * runner.sessionCount() : 0);
     }
 
     virtual Optional_Data getOptionalData() override
@@ -71,76 +92,77 @@ public:
         return data;
     }
 
+    virtual bool isPreprocessingThreadSafe() override
+    {
+        return true;
+    }
+
+    // Must change whenever convertToPreprocessedDataForInference(..) changes, so stale --cache files are rebuilt.
+    virtual string getPreprocessingSignature() override
+    {
+        return "BGR->RGB CHW float32 scale=1/255 mean=0.485,0.456,0.406 std=0.229,0.224,0.225";
+    }
+
     virtual VariantType convertToPreprocessedDataForInference(const string& imagePath) override
     {
         Mat image = imread(imagePath);
         if (image.empty()) {
             throw runtime_error("Failed to load image: " + imagePath);
         }
-
-        // convert BGR to RGB before reshaping
-        cvtColor(image, image, cv::COLOR_BGR2RGB);
-
-        // reshape (3D -> 1D)
-        image = image.reshape(1, 1);
-
-        // uint_8, [0, 255] -> float, [0 and 1] => Normalize number to between 0 and 1, Convert to vector<float> from cv::Mat.
-        vector<float> vec;
-        image.convertTo(vec, CV_32FC1, 1. / 255);
+        if (image.type() != CV_8UC3) {
+            throw runtime_error("Expected an 8-bit 3-channel image: " + imagePath);
+        }
 
         // Mean and Std deviation values
-        const vector<float> means = { 0.485, 0.456, 0.406 };
-        const vector<float> stds = { 0.229, 0.224, 0.225 };
-
-        // Transpose (Height, Width, Channel)(224,224,3) to (Chanel, Height, Width)(3,224,224)
-        vector<float> output;
-        for (size_t ch = 0; ch < 3; ++ch)
-        {
-            for (size_t i = ch; i < vec.size(); i += 3)
-            {
-                float normalized = (vec[i] - means[ch]) / stds[ch];
-                output.emplace_back(normalized);
-            }
-        }
+        const float means[3] = { 0.485f, 0.456f, 0.406f };
+        const float stds[3] = { 0.229f, 0.224f, 0.225f };
+        static const ChannelNormalization normalization = ChannelNormalization::fromMeanStd(means, stds, 1.0f / 255);
+
+        // Single pass (AVX-512 or AVX2 when available): BGR -> RGB, [0, 255] -> [0, 1], (x - mean) / std,
+        // and transpose (Height, Width, Channel)(H,W,3) to (Channel, Height, Width)(3,H,W) into a pre-sized buffer.
+        BMTDataType output(3 * (size_t)image.rows * image.cols);
+        convertBgrToNormalizedPlanarRgb(image.data, image.rows, image.cols, image.step, normalization, output.data());
+#ifdef AI_BMT_CLI_BUILD
+        return TensorView::wrap(move(output), { 3, image.rows, image.cols });
+#else
         return output;
+#endif
     }
 
     virtual vector<BMTResult> runInference(const vector<VariantType>& data) override
     {
-        const int querySize = data.size();
-        vector<BMTResult> results;
-
-        //onnx option setting
-        const vector<int64_t> input_dims = { 1, 3, 520, 520 };
-        const vector<int64_t> output_shape = { 1, 21, 520, 520 };
-
-        for (int i = 0; i < querySize; ++i) {
-            // Prepare input/output tensors
-            BMTDataType imageVec;
-            try {
-                imageVec = get<BMTDataType>(data[i]);
-            }
-            catch (const std::bad_variant_access& e) {
-                cerr << "Error: bad_variant_access at index " << i << ". Reason: " << e.what() << endl;
-                continue;
+        AI_BMT_SCOPED_STAGE("stage.runInference");
+        // Extras of results the caller did not release belong to no live result any more.
+        extras.clear([this](BMTResultExtras& resultExtras) { recycleExtras(resultExtras); });
+        return runner.run(data, [this](BMTResult& result, vector<float>&& outputData) {
+            if (!classMapOutput)
+            {
+                if (encodeOutput)
+                {
+                    encoder.encode(outputData.data(), outputData.size(), extras.emplace(result).segmentationResultEncoded);
+                    runner.releaseOutput(move(outputData));
+                }
+                else
+                    result.segmentationResult = move(outputData);
+                return;
             }
+            // Compact path: argmax per pixel here and hand the logits straight back to the pool.
+            vector<uint8_t>& classMap = extras.emplace(result).segmentationClassMap;
+            classMap = classMapPool.acquire();
+            argmaxToClassMap(outputData.data(), classCount, planeSize, classMap.data());
+            runner.releaseOutput(move(outputData));
+        });
+    }
 
-            vector<float> output_data(output_shape[1] * output_shape[2] * output_shape[3]);
-            auto input_tensor = Ort::Value::CreateTensor<float>(
-                memory_info, imageVec.data(), imageVec.size(), input_dims.data(), input_dims.size());
-
-            auto output_tensor = Ort::Value::CreateTensor<float>(
-                memory_info, output_data.data(), output_data.size(),
-                output_shape.data(), output_shape.size());
-
-            session->Run(runOptions, inputNames.data(), &input_tensor, 1, outputNames.data(), &output_tensor, 1);
+    virtual void releaseResults(vector<BMTResult>& results) override
+    {
+        runner.recycleOutputs(results, &BMTResult::segmentationResult);
+        extras.release(results, [this](BMTResultExtras& resultExtras) { recycleExtras(resultExtras); });
+    }
 
-            // Update results
-            BMTResult result;
-            result.segmentationResult = output_data;
-            results.push_back(result);
-        }
-        return results;
+    virtual const BMTResultExtras* resultExtras(const BMTResult& result) const override
+    {
+        return extras.find(result);
     }
 };
 
@@ -152,8 +174,13 @@ int main(int argc, char* argv[])
     try
     {
         shared_ptr<AI_BMT_Interface> interface = make_shared<ImageSegmentation_Interface_Implementation>();
+#if defined(_WIN32) && !defined(AI_BMT_HEADLESS)
         AI_BMT_GUI_CALLER caller(interface, modelPath);
         return caller.call_BMT_GUI(argc, argv);
+#else
+        AI_BMT_CLI_CALLER caller(interface, modelPath);
+        return caller.call_BMT_CLI(argc, argv);
+#endif
     }
     catch (const exception& ex)
     {
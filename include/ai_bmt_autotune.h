@@ -0,0 +1,316 @@
+#ifndef AI_BMT_AUTOTUNE_H
+#define AI_BMT_AUTOTUNE_H
+
+#include "ai_bmt_file_utils.h"
+#include "ai_bmt_interface.h"
+#include "ai_bmt_latency_histogram.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// "key=value" runtime settings of one autotune point, as in "<modelPath>.cfg".
+using AutotuneSettings = vector<pair<string, string>>;
+
+// One swept setting and its candidate values. A value may set several keys at once
+// (e.g., inter_op_threads together with execution_mode).
+struct AutotuneDimension
+{
+    string name;
+    vector<AutotuneSettings> values;
+};
+
+struct AutotuneResult
+{
+    AutotuneSettings settings;
+    size_t queriesPerCall = 1;
+    double throughputQps = 0;
+    double p50Ms = 0;
+    double p99Ms = 0;
+    bool pareto = false;
+    string error; // Non-empty if Initialize or runInference failed at this point
+
+    string label() const
+    {
+        string text;
+        for (const auto& setting : settings)
+            text += (text.empty() ? "" : " ") + setting.first + "=" + setting.second;
+        return text;
+    }
+};
+
+// Sweeps runtime settings of an implementation that reads them at Initialize (see Ort_Runtime_Config.h).
+// Every point exports its settings, re-initializes the implementation and times runInference(..) over the
+// preprocessed dataset in calls of batch_size x session_count queries (1 for settings not swept). The result is the
+// Pareto front of throughput and p99 query latency; choose(..) picks one point of it for the profile.
+class Autotuner
+{
+private:
+    using Clock = chrono::steady_clock;
+
+    // Moves an existing profile out of the way for the duration of a sweep and puts it back afterwards.
+    // Every Initialize of the sweep would otherwise load it, and its keys would leak into points that do not set them
+    // (e.g., inter_op_threads when it is not swept), so the measurements would not match the profile written after.
+    class ProfileSetAside
+    {
+    private:
+        string path;
+        string asidePath;
+
+    public:
+        ProfileSetAside(const string& profilePath, ostream& out) : path(profilePath)
+        {
+            error_code error;
+            if (!filesystem::exists(path, error))
+                return;
+            asidePath = path + ".previous";
+            filesystem::rename(path, asidePath, error);
+            if (error)
+                throw runtime_error("Failed to move the existing autotune profile " + path + " aside: " + error.message());
+            out << "[AI BMT] Existing autotune profile ignored during the sweep: " << path << endl;
+        }
+
+        ~ProfileSetAside()
+        {
+            if (asidePath.empty())
+                return;
+            error_code error;
+            filesystem::rename(asidePath, path, error);
+        }
+
+        ProfileSetAside(const ProfileSetAside&) = delete;
+        ProfileSetAside& operator=(const ProfileSetAside&) = delete;
+    };
+
+    AI_BMT_Interface& interface;
+    string modelPath;
+    vector<VariantType>& dataset;
+    function<bool(const string&)> exportSetting;
+
+    // batch_size queries for each of session_count sessions, so a session pool gets one batch per session.
+    static size_t queriesPerCall(const AutotuneSettings& settings, size_t datasetSize)
+    {
+        size_t queries = 1;
+        for (const auto& setting : settings)
+        {
+            if (setting.first == "batch_size" || setting.first == "session_count")
+                queries *= max<size_t>(1, stoul(setting.second));
+        }
+        return min(queries, datasetSize);
+    }
+
+    void runCall(vector<VariantType>& batch)
+    {
+        vector<BMTResult> results = interface.runInference(batch);
+        interface.releaseResults(results);
+    }
+
+    AutotuneResult measure(const AutotuneSettings& settings)
+    {
+        AutotuneResult result;
+        result.settings = settings;
+        result.queriesPerCall = queriesPerCall(settings, dataset.size());
+        for (const auto& setting : settings)
+        {
+            if (!exportSetting(setting.first + "=" + setting.second))
+                throw runtime_error("Failed to export setting " + setting.first);
+        }
+
+        // Samples are moved into each call and back, so batching copies nothing.
+        vector<VariantType> batch;
+        auto fillBatch = [&](size_t begin) {
+            const size_t end = min(begin + result.queriesPerCall, dataset.size());
+            batch.assign(make_move_iterator(dataset.begin() + begin), make_move_iterator(dataset.begin() + end));
+        };
+        auto returnBatch = [&](size_t begin) {
+            move(batch.begin(), batch.end(), dataset.begin() + begin);
+            batch.clear();
+        };
+
+        size_t begin = 0;
+        try {
+            interface.Initialize(modelPath);
+            fillBatch(0);
+            for (int i = 0; i < warmup; ++i)
+                runCall(batch);
+            returnBatch(0);
+
+            LatencyHistogram latency;
+            Clock::duration total = Clock::duration::zero();
+            size_t queries = 0;
+            for (int iteration = 0; iteration < iterations; ++iteration)
+            {
+                for (begin = 0; begin < dataset.size(); begin += result.queriesPerCall)
+                {
+                    fillBatch(begin);
+                    Clock::time_point start = Clock::now();
+                    vector<BMTResult> results = interface.runInference(batch);
+                    Clock::duration elapsed = Clock::now() - start;
+                    interface.releaseResults(results);
+                    // Every query of the call waits for the whole call.
+                    for (size_t i = 0; i < batch.size(); ++i)
+                        latency.record(elapsed);
+                    total += elapsed;
+                    queries += batch.size();
+                    returnBatch(begin);
+                }
+            }
+            const double totalS = chrono::duration<double>(total).count();
+            result.throughputQps = totalS > 0 ? queries / totalS : 0;
+            result.p50Ms = latency.percentileNs(50) / 1e6;
+            result.p99Ms = latency.percentileNs(99) / 1e6;
+        }
+        catch (const exception& e) {
+            if (!batch.empty())
+                returnBatch(begin);
+            result.error = e.what();
+        }
+        return result;
+    }
+
+public:
+    int warmup = 1;
+    int iterations = 1;
+    double latencyBoundMs = 0; // choose(..) only considers points with p99 <= bound (0 = no bound)
+    double throughputTolerance = 0.05;
+
+    // exportSetting applies one "key=value" setting before the next Initialize (e.g., as AI_BMT_<MODEL STEM>_<KEY>).
+    Autotuner(AI_BMT_Interface& interface, const string& modelPath, vector<VariantType>& dataset, function<bool(const string&)> exportSetting)
+        : interface(interface), modelPath(modelPath), dataset(dataset), exportSetting(move(exportSetting))
+    {
+        if (dataset.empty())
+            throw runtime_error("Autotuning needs a non-empty dataset");
+    }
+
+    // Cartesian product of the dimensions.
+    static vector<AutotuneSettings> expand(const vector<AutotuneDimension>& dimensions)
+    {
+        vector<AutotuneSettings> points = { AutotuneSettings() };
+        for (const AutotuneDimension& dimension : dimensions)
+        {
+            if (dimension.values.empty())
+                continue;
+            vector<AutotuneSettings> expanded;
+            for (const AutotuneSettings& point : points)
+            {
+                for (const AutotuneSettings& value : dimension.values)
+                {
+                    AutotuneSettings combined = point;
+                    combined.insert(combined.end(), value.begin(), value.end());
+                    expanded.push_back(move(combined));
+                }
+            }
+            points = move(expanded);
+        }
+        return points;
+    }
+
+    vector<AutotuneResult> sweep(const vector<AutotuneDimension>& dimensions, ostream& out)
+    {
+        const vector<AutotuneSettings> points = expand(dimensions);
+        ProfileSetAside previousProfile(autotuneProfilePath(modelPath), out);
+        vector<AutotuneResult> results;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            results.push_back(measure(points[i]));
+            const AutotuneResult& result = results.back();
+            out << "[AI BMT] Autotune " << (i + 1) << "/" << points.size() << ": " << result.label();
+            if (result.error.empty())
+                out << " -> " << result.throughputQps << " queries/s, p99 " << result.p99Ms << " ms" << endl;
+            else
+                out << " -> failed: " << result.error << endl;
+        }
+        markParetoFront(results);
+        return results;
+    }
+
+    // A point is on the front if no other point has both higher (or equal) throughput and lower (or equal) p99.
+    static void markParetoFront(vector<AutotuneResult>& results)
+    {
+        for (AutotuneResult& candidate : results)
+        {
+            candidate.pareto = candidate.error.empty();
+            for (const AutotuneResult& other : results)
+            {
+                if (!candidate.pareto)
+                    break;
+                if (&other == &candidate || !other.error.empty())
+                    continue;
+                const bool noWorse = other.throughputQps >= candidate.throughputQps && other.p99Ms <= candidate.p99Ms;
+                const bool better = other.throughputQps > candidate.throughputQps || other.p99Ms < candidate.p99Ms;
+                if (noWorse && better)
+                    candidate.pareto = false;
+            }
+        }
+    }
+
+    // Among front points within the latency bound: the lowest p99 whose throughput is within throughputTolerance
+    // of the best throughput, i.e., do not pay a large latency increase for the last few percent of throughput.
+    // Returns nullptr if no point qualifies.
+    const AutotuneResult* choose(const vector<AutotuneResult>& results) const
+    {
+        double bestThroughput = 0;
+        for (const AutotuneResult& result : results)
+        {
+            if (result.pareto && (latencyBoundMs <= 0 || result.p99Ms <= latencyBoundMs))
+                bestThroughput = max(bestThroughput, result.throughputQps);
+        }
+        const AutotuneResult* chosen = nullptr;
+        for (const AutotuneResult& result : results)
+        {
+            if (!result.pareto || (latencyBoundMs > 0 && result.p99Ms > latencyBoundMs))
+                continue;
+            if (result.throughputQps < bestThroughput * (1.0 - throughputTolerance))
+                continue;
+            if (chosen == nullptr || result.p99Ms < chosen->p99Ms)
+                chosen = &result;
+        }
+        return chosen;
+    }
+
+    static void printResults(ostream& out, const vector<AutotuneResult>& results, const AutotuneResult* chosen)
+    {
+        const ios::fmtflags flags = out.flags();
+        const streamsize precision = out.precision();
+        out << "[AI BMT] Autotune results (* = Pareto front, > = chosen):" << endl;
+        out << "[AI BMT]     " << right << setw(12) << "queries/s" << setw(10) << "p50 ms" << setw(10) << "p99 ms" << "  settings" << endl;
+        out << fixed << setprecision(2);
+        for (const AutotuneResult& result : results)
+        {
+            out << "[AI BMT]   " << (&result == chosen ? '>' : ' ') << (result.pareto ? '*' : ' ');
+            if (result.error.empty())
+                out << setw(12) << result.throughputQps << setw(10) << result.p50Ms << setw(10) << result.p99Ms;
+            else
+                out << setw(12) << "failed" << setw(10) << "" << setw(10) << "";
+            out << "  " << result.label() << endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // Writes the chosen settings in "<modelPath>.cfg" format, with the measurement as a comment.
+    // The sweep ran without any previous profile, so the swept keys are the only ones it contributed.
+    static void writeProfile(const string& path, const string& modelPath, const AutotuneResult& result)
+    {
+        ofstream file(path);
+        if (!file)
+            throw runtime_error("Failed to write " + path);
+        file << "# AI BMT autotune profile of " << modelPath << " on " << autotuneHostName() << endl;
+        file << "# " << result.throughputQps << " queries/s, p50 " << result.p50Ms << " ms, p99 " << result.p99Ms << " ms" << endl;
+        file << "# Keys also set in " << modelPath << ".cfg override the values below" << endl;
+        for (const auto& setting : result.settings)
+            file << setting.first << "=" << setting.second << endl;
+    }
+};
+
+#endif // AI_BMT_AUTOTUNE_H
@@ -0,0 +1,100 @@
+#ifndef AI_BMT_BOUNDED_QUEUE_H
+#define AI_BMT_BOUNDED_QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+using namespace std;
+
+// Producer/consumer queue bounded by a memory budget in bytes rather than an item count.
+// Bytes stay charged after pop() until the consumer calls release(), so items the consumer
+// is still holding (e.g., a batch passed to runInference) count against the budget too.
+// At least minInFlight items are always admitted, so a budget smaller than one batch cannot deadlock.
+template <typename T>
+class BoundedByteQueue
+{
+private:
+    struct Entry
+    {
+        T item;
+        size_t bytes;
+    };
+
+    mutex queueMutex;
+    condition_variable notFull;
+    condition_variable notEmpty;
+    deque<Entry> entries;
+    size_t budgetBytes;
+    size_t minInFlight;
+    size_t chargedBytes = 0;
+    size_t inFlightItems = 0;
+    size_t peakBytes = 0;
+    bool closed = false;
+
+public:
+    BoundedByteQueue(size_t budgetBytes, size_t minInFlight = 1)
+        : budgetBytes(budgetBytes), minInFlight(minInFlight)
+    {
+    }
+
+    // Blocks while the budget is exhausted. Returns false if the queue was closed.
+    bool push(T item, size_t bytes)
+    {
+        unique_lock<mutex> lock(queueMutex);
+        notFull.wait(lock, [&] { return closed || inFlightItems < minInFlight || chargedBytes + bytes <= budgetBytes; });
+        if (closed)
+            return false;
+        chargedBytes += bytes;
+        peakBytes = max(peakBytes, chargedBytes);
+        ++inFlightItems;
+        entries.push_back({ move(item), bytes });
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks until an item is available. Returns false once the queue is closed and drained.
+    bool pop(T& item, size_t& bytes)
+    {
+        unique_lock<mutex> lock(queueMutex);
+        notEmpty.wait(lock, [&] { return closed || !entries.empty(); });
+        if (entries.empty())
+            return false;
+        item = move(entries.front().item);
+        bytes = entries.front().bytes;
+        entries.pop_front();
+        return true;
+    }
+
+    // Returns the budget held by popped items once the consumer no longer needs them.
+    void release(size_t bytes, size_t items = 1)
+    {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            chargedBytes -= bytes;
+            inFlightItems -= items;
+        }
+        notFull.notify_all();
+    }
+
+    // Wakes all waiters; producers stop, the consumer drains what is left.
+    void close()
+    {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            closed = true;
+        }
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    size_t peakChargedBytes()
+    {
+        lock_guard<mutex> lock(queueMutex);
+        return peakBytes;
+    }
+};
+
+#endif // AI_BMT_BOUNDED_QUEUE_H
@@ -0,0 +1,899 @@
+#ifndef AI_BMT_CLI_CALLER_H
+#define AI_BMT_CLI_CALLER_H
+
+#include "ai_bmt_interface.h"
+#include "ai_bmt_autotune.h"
+#include "ai_bmt_bounded_queue.h"
+#include "ai_bmt_latency_histogram.h"
+#include "ai_bmt_op_profile.h"
+#include "ai_bmt_perf_counters.h"
+#include "ai_bmt_preprocessed_cache.h"
+#include "ai_bmt_result_check.h"
+#include "ai_bmt_scenarios.h"
+#include "ai_bmt_stage_timer.h"
+#include "ai_bmt_trace.h"
+#include "ai_bmt_thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Headless replacement for AI_BMT_GUI_CALLER.
+// It drives any AI_BMT_Interface implementation from the command line without a display:
+// Initialize -> convertToPreprocessedDataForInference (untimed) -> runInference (timed),
+// and prints latency and throughput to stdout.
+//
+// Usage: <exe> --dataset <dir> [--model <path>] [--limit N] [--batch N] [--warmup N] [--iterations N] [--threads N] [--stream MB] [--cache <file>]
+//              [--scenario <name> [--queries N] [--duration S] [--samples-per-query N] [--interval-ms X] [--target-qps X] [--latency-bound-ms X]]
+//              [--autotune 1 [--tune-intra list] [--tune-inter list] [--tune-batch list] [--tune-sessions list]]
+//              [--latency-csv <file>] [--trace <file>] [--stages 0|1] [--hw-counters 0|1] [--op-profile N] [--check-results N] [--set key=value]...
+//   --dataset     Directory containing the input images (searched recursively).
+//   --model       Overrides the model path given to the constructor.
+//   --limit       Uses at most N images from the dataset (0 = all).
+//   --batch       Number of queries handed to a single runInference(..) call (0 = all at once). Each call is one latency
+//                 sample, so percentiles need about 100 calls (a warning says when there are fewer): use --batch 1 for
+//                 per-query latency, or more --iterations.
+//   --warmup      Untimed runInference(..) calls on the first batch before measuring.
+//   --iterations  Number of timed passes over the whole dataset.
+//   --threads     Preprocessing threads when the implementation reports isPreprocessingThreadSafe()
+//                 (0 = all hardware threads, default).
+//   --stream      Streaming mode with a memory budget in MB: preprocessing runs ahead of inference
+//                 through a bounded queue instead of loading the whole dataset into RAM first.
+//                 Only runInference(..) is timed. --batch 0 means 1 in this mode.
+//   --cache       Preprocessed-data cache file. Built on the first run (or when the images or
+//                 getPreprocessingSignature() change) and memory-mapped afterwards, so later runs skip
+//                 preprocessing and hand raw pointers into the mapping to runInference(..). Overrides --stream.
+//   --scenario    Runs a LoadGen-style scenario (SingleStream, MultiStream, Server or Offline, see ai_bmt_scenarios.h)
+//                 on the preprocessed dataset instead of timing fixed batches. --batch is the Server/Offline batch limit
+//                 (0 = 1 for Server, all for Offline); --iterations and --stream do not apply.
+//     --queries           Minimum number of queries (0 = one per image, default).
+//     --duration          Minimum duration in seconds.
+//     --samples-per-query MultiStream samples per query (default 8).
+//     --interval-ms       MultiStream query interval (default 50).
+//     --target-qps        Server Poisson arrival rate (default 10).
+//     --latency-bound-ms  Server p99 latency bound for a VALID result (default none).
+//   --autotune    Sweeps runtime settings instead of a single measurement: every combination of the lists below is
+//                 exported like --set, the implementation is re-initialized and the dataset is timed (--warmup,
+//                 --iterations) in runInference(..) calls of batch_size x session_count queries. The Pareto front of throughput and
+//                 p99 is printed and the chosen point (see Autotuner::choose, honoring --latency-bound-ms) is written
+//                 to "<model>.<host>.autotune", which the ONNX Runtime examples load at Initialize.
+//     --tune-intra  intra_op_threads values (default 1, 2, 4, ... up to the hardware threads).
+//     --tune-inter  inter_op_threads values; 0 = sequential execution, N = parallel execution (default not swept).
+//                   With global_thread_pools the thread values size process-wide pools, which the ONNX Runtime examples
+//                   rebuild at every point's Initialize; they stay fixed (with a warning) while another model holds them.
+//     --tune-batch  batch_size values (default 1, 2, 4, 8, 16 up to the dataset size).
+//     --tune-sessions session_count values (default 1, 2, 4 up to the hardware threads).
+//   --latency-csv Writes the latency percentile table (per runInference call, per query in --scenario runs and per
+//                 AI_BMT_SCOPED_STAGE stage) as CSV.
+//   --trace       Writes a Chrome trace (chrome://tracing, ui.perfetto.dev) of Initialize, preprocessing, queueing
+//                 and runInference spans, merged on the same clock with the ONNX Runtime operator profile of
+//                 implementations that read the "profiling" setting (exported like --set profiling=1).
+//   --stages      Enables the AI_BMT_SCOPED_STAGE timers of the implementation at run time (on by default in builds with
+//                 AI_BMT_STAGE_TIMERS) and prints a stage breakdown of runInference(..) next to their percentiles.
+//   --hw-counters Linux only: perf_event_open counters (CPU time, cycles, instructions, IPC, LLC misses, estimated
+//                 memory bandwidth) per query for runInference (the threads of the process after Initialize, including
+//                 the inference runtime's pool; --stream preprocessing threads are excluded) and per preprocessing call
+//                 (the converting thread). Skipped with a note when counters are unavailable (e.g., containers,
+//                 kernel.perf_event_paranoid > 2).
+//   --op-profile  Prints an operator hotspot table per model from the ONNX Runtime profiles (also enables "profiling"):
+//                 kernel time per operator type and the N most expensive nodes, with calls and share, after warm-up.
+//   --check-results Before measuring, runs the first N images in the configured result mode and again with raw float32
+//                 results (detection_output=raw, segmentation_output=raw, result_encoding=float32, re-initializing the
+//                 implementation in between), and compares the two: boxes against the implementation's decode of the
+//                 raw output (BMTResultExtrasProvider::referenceBoxes), class maps against the argmax of the raw
+//                 logits, and fp16/int8 outputs against float32 (max abs error, size). Exits with 1 on a mismatch.
+//                 Fixed-batch runs also print the result bytes (and boxes) per query, read outside the measured region.
+//   --set         Exports "AI_BMT_<MODEL STEM>_<KEY>=value" before Initialize so implementations can read
+//                 runtime settings of the model under test (e.g., --set batch_size=16) without recompiling.
+//                 These override the model's .cfg and autotune profile; see settingEnvironmentName(..).
+class AI_BMT_CLI_CALLER
+{
+private:
+    struct Options
+    {
+        string datasetDir;
+        size_t limit = 0;
+        size_t batchSize = 0;
+        int warmup = 1;
+        int iterations = 1;
+        size_t preprocessingThreads = 0;
+        size_t streamBudgetMb = 0; // 0 = load the whole dataset before inference
+        string cachePath;
+        string latencyCsvPath;
+        string tracePath;
+        bool stageTimers = stageTimersEnabled();
+        bool hardwareCounters = false;
+        size_t opProfileNodes = 0; // 0 = no operator profile summary
+        size_t checkResults = 0; // Queries compared with raw results before measuring
+        bool runScenario = false;
+        bool autotune = false;
+        vector<size_t> tuneIntraOpThreads;
+        vector<size_t> tuneInterOpThreads;
+        vector<size_t> tuneBatchSizes;
+        vector<size_t> tuneSessionCounts;
+        vector<string> settings; // --set values, exported once --model is known
+        ScenarioSettings scenario;
+    };
+
+    struct Measurement
+    {
+        vector<double> callLatenciesMs;
+        size_t queryCount = 0;
+        double totalMs = 0;
+
+        void add(double ms, size_t queries)
+        {
+            callLatenciesMs.push_back(ms);
+            totalMs += ms;
+            queryCount += queries;
+        }
+    };
+
+    shared_ptr<AI_BMT_Interface> interface;
+    string modelPath;
+    PreprocessedCache cache; // Keeps the mapping alive while queries point into it
+    LatencyHistogram& inferenceLatency = LatencyRecorder::instance().histogram("runInference");
+    int64_t measurementStartNs = 0; // traceClockNs() after warm-up, for filtering the operator profile
+    ResultOutputSummary resultOutput; // Result bytes (and boxes) per query of the timed calls
+
+    static void printUsage(const char* exeName)
+    {
+        cerr << "Usage: " << exeName << " --dataset <dir> [--model <path>] [--limit N] [--batch N] [--warmup N] [--iterations N] [--threads N] [--stream MB] [--cache <file>]" << endl
+             << "       [--scenario SingleStream|MultiStream|Server|Offline [--queries N] [--duration S] [--samples-per-query N] [--interval-ms X] [--target-qps X] [--latency-bound-ms X]]" << endl
+             << "       [--autotune 1 [--tune-intra list] [--tune-inter list] [--tune-batch list] [--tune-sessions list]]" << endl
+             << "       [--latency-csv <file>] [--trace <file>] [--stages 0|1] [--hw-counters 0|1] [--op-profile N] [--check-results N] [--set key=value]..." << endl;
+    }
+
+    bool parseArguments(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            string arg = argv[i];
+            if (arg == "--help" || arg == "-h")
+                return false;
+            if (i + 1 >= argc)
+            {
+                cerr << "Missing value for argument: " << arg << endl;
+                return false;
+            }
+            string value = argv[++i];
+            if (arg == "--dataset")
+                options.datasetDir = value;
+            else if (arg == "--model")
+                modelPath = value;
+            else if (arg == "--limit")
+                options.limit = stoul(value);
+            else if (arg == "--batch")
+                options.batchSize = stoul(value);
+            else if (arg == "--warmup")
+                options.warmup = stoi(value);
+            else if (arg == "--iterations")
+                options.iterations = max(1, stoi(value));
+            else if (arg == "--threads")
+                options.preprocessingThreads = stoul(value);
+            else if (arg == "--stream")
+                options.streamBudgetMb = stoul(value);
+            else if (arg == "--cache")
+                options.cachePath = value;
+            else if (arg == "--scenario")
+            {
+                options.runScenario = true;
+                if (!parseScenario(value, options.scenario.scenario))
+                {
+                    cerr << "Unknown scenario: " << value << endl;
+                    return false;
+                }
+            }
+            else if (arg == "--autotune")
+                options.autotune = stoi(value) != 0;
+            else if (arg == "--tune-intra")
+                options.tuneIntraOpThreads = parseList(value);
+            else if (arg == "--tune-inter")
+                options.tuneInterOpThreads = parseList(value);
+            else if (arg == "--tune-batch")
+                options.tuneBatchSizes = parseList(value);
+            else if (arg == "--tune-sessions")
+                options.tuneSessionCounts = parseList(value);
+            else if (arg == "--latency-csv")
+                options.latencyCsvPath = value;
+            else if (arg == "--trace")
+                options.tracePath = value;
+            else if (arg == "--stages")
+                options.stageTimers = stoi(value) != 0;
+            else if (arg == "--hw-counters")
+                options.hardwareCounters = stoi(value) != 0;
+            else if (arg == "--op-profile")
+                options.opProfileNodes = stoul(value);
+            else if (arg == "--check-results")
+                options.checkResults = stoul(value);
+            else if (arg == "--queries")
+                options.scenario.minQueryCount = stoul(value);
+            else if (arg == "--duration")
+                options.scenario.minDurationS = stod(value);
+            else if (arg == "--samples-per-query")
+                options.scenario.samplesPerQuery = stoul(value);
+            else if (arg == "--interval-ms")
+                options.scenario.intervalMs = stod(value);
+            else if (arg == "--target-qps")
+            {
+                options.scenario.targetQps = stod(value);
+                if (!(options.scenario.targetQps > 0) || !isfinite(options.scenario.targetQps))
+                {
+                    cerr << "--target-qps must be a positive number: " << value << endl;
+                    return false;
+                }
+            }
+            else if (arg == "--latency-bound-ms")
+                options.scenario.latencyBoundMs = stod(value);
+            else if (arg == "--set")
+            {
+                options.settings.push_back(value);
+                if (value.find('=') == string::npos || value.front() == '=')
+                {
+                    cerr << "Invalid --set value (expected key=value): " << value << endl;
+                    return false;
+                }
+            }
+            else
+            {
+                cerr << "Unknown argument: " << arg << endl;
+                return false;
+            }
+        }
+        if (options.datasetDir.empty())
+        {
+            cerr << "--dataset is required." << endl;
+            return false;
+        }
+        enableStageTimers(options.stageTimers);
+        for (const string& setting : options.settings)
+        {
+            if (!exportSetting(setting))
+            {
+                cerr << "Failed to export --set " << setting << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // "1,2,4" -> {1, 2, 4}
+    static vector<size_t> parseList(const string& text)
+    {
+        vector<size_t> values;
+        size_t begin = 0;
+        while (begin <= text.size())
+        {
+            size_t end = text.find(',', begin);
+            if (end == string::npos)
+                end = text.size();
+            if (end > begin)
+                values.push_back(stoul(text.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+        return values;
+    }
+
+    // Exports "key=value" as AI_BMT_<MODEL STEM>_<KEY>=value for the model under test, or with forAllModels as
+    // AI_BMT_<KEY>=value, the lowest-priority default of every model in the process.
+    bool exportSetting(const string& setting, bool forAllModels = false) const
+    {
+        size_t separator = setting.find('=');
+        if (separator == string::npos || separator == 0)
+            return false;
+        string name = settingEnvironmentName(setting.substr(0, separator), forAllModels ? "" : modelPath);
+        string value = setting.substr(separator + 1);
+#ifdef _WIN32
+        return _putenv_s(name.c_str(), value.c_str()) == 0;
+#else
+        return setenv(name.c_str(), value.c_str(), 1) == 0;
+#endif
+    }
+
+    // Value of a setting's variable for the model under test before a temporary exportSetting(..).
+    struct SavedSetting
+    {
+        string name;
+        bool wasSet = false;
+        string value;
+    };
+
+    SavedSetting saveSetting(const string& key) const
+    {
+        SavedSetting saved;
+        saved.name = settingEnvironmentName(key, modelPath);
+        const char* value = getenv(saved.name.c_str());
+        saved.wasSet = value != nullptr;
+        saved.value = value ? value : "";
+        return saved;
+    }
+
+    static void restoreSetting(const SavedSetting& saved)
+    {
+#ifdef _WIN32
+        _putenv_s(saved.name.c_str(), saved.wasSet ? saved.value.c_str() : "");
+#else
+        if (saved.wasSet)
+            setenv(saved.name.c_str(), saved.value.c_str(), 1);
+        else
+            unsetenv(saved.name.c_str());
+#endif
+    }
+
+    static vector<string> collectImagePaths(const string& datasetDir, size_t limit)
+    {
+        if (!filesystem::is_directory(datasetDir))
+            throw runtime_error("Dataset directory not found: " + datasetDir);
+
+        const vector<string> extensions = { ".jpg", ".jpeg", ".png", ".bmp" };
+        vector<string> imagePaths;
+        for (const auto& entry : filesystem::recursive_directory_iterator(datasetDir))
+        {
+            if (!entry.is_regular_file())
+                continue;
+            string extension = entry.path().extension().string();
+            transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+            if (find(extensions.begin(), extensions.end(), extension) != extensions.end())
+                imagePaths.push_back(entry.path().string());
+        }
+
+        // Sort so that repeated runs process the dataset in the same order.
+        sort(imagePaths.begin(), imagePaths.end());
+        if (limit > 0 && imagePaths.size() > limit)
+            imagePaths.resize(limit);
+        return imagePaths;
+    }
+
+    static double elapsedMs(chrono::steady_clock::time_point start, chrono::steady_clock::time_point end)
+    {
+        return chrono::duration<double, milli>(end - start).count();
+    }
+
+    static void printOptionalData(const Optional_Data& data)
+    {
+        const vector<pair<string, string>> fields = {
+            { "CPU Type", data.cpu_type },
+            { "Accelerator Type", data.accelerator_type },
+            { "Submitter", data.submitter },
+            { "CPU Core Count", data.cpu_core_count },
+            { "CPU RAM Capacity", data.cpu_ram_capacity },
+            { "Cooling", data.cooling },
+            { "Cooling Option", data.cooling_option },
+            { "CPU-Accelerator Interconnect", data.cpu_accelerator_interconnect_interface },
+            { "Benchmark Model", data.benchmark_model },
+            { "Operating System", data.operating_system },
+        };
+        for (const auto& field : fields)
+        {
+            if (!field.second.empty())
+                cout << "  " << field.first << ": " << field.second << endl;
+        }
+    }
+
+    template <typename T>
+    static size_t payloadBytes(const vector<T>& value) { return value.size() * sizeof(T); }
+
+#ifdef AI_BMT_CLI_BUILD
+    static size_t payloadBytes(const TensorView& value) { return value.ownsData() ? value.byteCount() : 0; }
+#endif
+
+    template <typename T>
+    static size_t payloadBytes(const T&) { return 0; }
+
+    // Bytes owned by a preprocessed query. Raw pointers and borrowed tensor views are owned elsewhere and count as 0.
+    static size_t variantByteSize(const VariantType& data)
+    {
+        return visit([](const auto& value) { return payloadBytes(value); }, data);
+    }
+
+    VariantType convertImage(const string& imagePath)
+    {
+        TraceSpan span("harness", "preprocess", imagePath);
+        HardwareCounterRecorder& counters = HardwareCounterRecorder::instance();
+        if (!counters.isEnabled())
+            return interface->convertToPreprocessedDataForInference(imagePath);
+        HardwareCounterRecorder::Sample start = counters.sampleThread();
+        VariantType data = interface->convertToPreprocessedDataForInference(imagePath);
+        counters.recordThread("preprocess", start, 1);
+        return data;
+    }
+
+    // Converts every image, in parallel on a work-stealing pool when the implementation allows it.
+    vector<VariantType> preprocess(const vector<string>& imagePaths, const Options& options, size_t& threadCount)
+    {
+        vector<VariantType> data(imagePaths.size());
+        forEachImage(imagePaths.size(), options, threadCount, [&](size_t i) {
+            data[i] = convertImage(imagePaths[i]);
+        });
+        return data;
+    }
+
+    // Maps the preprocessed-data cache, rebuilding it first if it is missing or stale.
+    vector<VariantType> loadCachedData(const vector<string>& imagePaths, const Options& options, size_t& threadCount)
+    {
+        auto forEach = [&](size_t count, const function<void(size_t)>& body) {
+            forEachImage(count, options, threadCount, body);
+        };
+        const string signature = interface->getPreprocessingSignature();
+        string reason;
+        if (!cache.open(options.cachePath, imagePaths, signature, forEach, reason))
+        {
+            cout << "[AI BMT] Building preprocessed cache " << options.cachePath << " (" << reason << ")" << endl;
+            PreprocessedCache::build(options.cachePath, imagePaths, signature,
+                [&](size_t i) { return convertImage(imagePaths[i]); }, forEach);
+            reason.clear();
+            if (!cache.open(options.cachePath, imagePaths, signature, forEach, reason))
+                throw runtime_error("Failed to open the preprocessed cache just built: " + reason);
+        }
+        else
+        {
+            cout << "[AI BMT] Using preprocessed cache " << options.cachePath << endl;
+        }
+
+        vector<VariantType> data(cache.entryCount());
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = cache.entry(i);
+        return data;
+    }
+
+    template <typename Body>
+    void forEachImage(size_t count, const Options& options, size_t& threadCount, Body body)
+    {
+        if (!interface->isPreprocessingThreadSafe() || options.preprocessingThreads == 1)
+        {
+            threadCount = 1;
+            for (size_t i = 0; i < count; ++i)
+                body(i);
+            return;
+        }
+
+        WorkStealingThreadPool pool(options.preprocessingThreads);
+        threadCount = pool.threadCount();
+        pool.parallelFor(count, body);
+    }
+
+    // Untimed calls; the latency histograms are cleared afterwards so warm-up never shows up in percentiles.
+    void warmup(const vector<VariantType>& batch, int count)
+    {
+        TraceSpan span("harness", "warmup");
+        for (int i = 0; i < count; ++i)
+        {
+            vector<BMTResult> results = interface->runInference(batch);
+            interface->releaseResults(results);
+        }
+        LatencyRecorder::instance().reset();
+        measurementStartNs = traceClockNs();
+    }
+
+    // Times one runInference(..) call. Recycling the results happens outside the measured region.
+    void timedInference(const vector<VariantType>& batch, Measurement& measurement)
+    {
+        HardwareCounterRecorder& counters = HardwareCounterRecorder::instance();
+        HardwareCounterRecorder::Sample counterStart;
+        if (counters.isEnabled())
+            counterStart = counters.sampleProcess();
+        auto start = chrono::steady_clock::now();
+        const int64_t traceStartNs = traceClockNs();
+        vector<BMTResult> results = interface->runInference(batch);
+        auto end = chrono::steady_clock::now();
+        if (counters.isEnabled())
+            counters.recordProcess("runInference", counterStart, batch.size());
+        if (TraceRecorder::instance().isEnabled())
+            TraceRecorder::instance().recordSpan("harness", "runInference", traceStartNs, traceClockNs(), to_string(batch.size()) + " queries");
+        inferenceLatency.record(end - start);
+
+        if (results.size() != batch.size())
+            cerr << "Warning: runInference returned " << results.size() << " results for " << batch.size() << " queries." << endl;
+        measurement.add(elapsedMs(start, end), batch.size());
+
+        // Outside the measured region: read the results, then let the implementation recycle its output buffers.
+        for (const BMTResult& result : results)
+            resultOutput.add(result, findResultExtras(*interface, result));
+        interface->releaseResults(results);
+    }
+
+    // The whole dataset is preprocessed into RAM (or mapped from --cache) before the first timed query.
+    vector<VariantType> loadDataset(const vector<string>& imagePaths, const Options& options)
+    {
+        // Preprocessing is excluded from latency and throughput measurements.
+        size_t preprocessingThreads = 1;
+        auto preprocessStart = chrono::steady_clock::now();
+        vector<VariantType> data = options.cachePath.empty() ? preprocess(imagePaths, options, preprocessingThreads)
+                                                             : loadCachedData(imagePaths, options, preprocessingThreads);
+        auto preprocessEnd = chrono::steady_clock::now();
+        cout << "[AI BMT] Preprocessed " << data.size() << " images in " << elapsedMs(preprocessStart, preprocessEnd) << " ms ("
+             << preprocessingThreads << " thread(s))" << endl;
+        return data;
+    }
+
+    // Default mode: times fixed batches over the in-memory dataset.
+    Measurement runInMemory(const vector<string>& imagePaths, const Options& options, size_t batchSize)
+    {
+        vector<VariantType> data = loadDataset(imagePaths, options);
+        vector<vector<VariantType>> batches;
+        for (size_t begin = 0; begin < data.size(); begin += batchSize)
+        {
+            size_t end = min(begin + batchSize, data.size());
+            batches.emplace_back(make_move_iterator(data.begin() + begin), make_move_iterator(data.begin() + end));
+        }
+        data.clear();
+
+        warmup(batches.front(), options.warmup);
+
+        Measurement measurement;
+        for (int iteration = 0; iteration < options.iterations; ++iteration)
+        {
+            for (const auto& batch : batches)
+                timedInference(batch, measurement);
+        }
+        return measurement;
+    }
+
+    // A query in flight between a streaming producer and the consumer.
+    struct StreamedQuery
+    {
+        VariantType data;
+        int64_t enqueuedNs = 0; // traceClockNs() at push, for the trace's "queue" spans
+    };
+
+    // Streaming mode: producers preprocess ahead of inference through a queue bounded by a memory budget,
+    // so datasets larger than RAM can be measured. Each iteration streams the dataset again.
+    Measurement runStreaming(const vector<string>& imagePaths, const Options& options, size_t batchSize)
+    {
+        const size_t budgetBytes = options.streamBudgetMb * 1024 * 1024;
+        Measurement measurement;
+        size_t peakBytes = 0;
+        size_t preprocessingThreads = 1;
+        for (int iteration = 0; iteration < options.iterations; ++iteration)
+        {
+            BoundedByteQueue<StreamedQuery> queue(budgetBytes, batchSize);
+            atomic<bool> cancelled{ false };
+            exception_ptr producerError;
+            thread producer([&] {
+                try {
+                    forEachImage(imagePaths.size(), options, preprocessingThreads, [&](size_t i) {
+                        if (cancelled.load())
+                            return;
+                        // Preprocessing overlaps the timed runInference(..) calls; keep it out of their counters.
+                        HardwareCounterRecorder::instance().excludeCallingThread();
+                        StreamedQuery item{ convertImage(imagePaths[i]), traceClockNs() };
+                        size_t bytes = variantByteSize(item.data);
+                        queue.push(move(item), bytes);
+                    });
+                }
+                catch (...) {
+                    producerError = current_exception();
+                }
+                queue.close();
+            });
+
+            try {
+                vector<VariantType> batch;
+                size_t batchBytes = 0;
+                bool warmedUp = iteration > 0;
+                while (true)
+                {
+                    StreamedQuery item;
+                    size_t bytes = 0;
+                    bool more = queue.pop(item, bytes);
+                    if (more)
+                    {
+                        TraceRecorder::instance().recordSpan("harness", "queue", item.enqueuedNs, traceClockNs());
+                        batch.push_back(move(item.data));
+                        batchBytes += bytes;
+                    }
+                    if (batch.size() == batchSize || (!more && !batch.empty()))
+                    {
+                        if (!warmedUp)
+                        {
+                            warmup(batch, options.warmup);
+                            warmedUp = true;
+                        }
+                        timedInference(batch, measurement);
+                        queue.release(batchBytes, batch.size());
+                        batch.clear();
+                        batchBytes = 0;
+                    }
+                    if (!more)
+                        break;
+                }
+            }
+            catch (...) {
+                cancelled = true;
+                queue.close();
+                producer.join();
+                throw;
+            }
+            producer.join();
+            if (producerError)
+                rethrow_exception(producerError);
+            peakBytes = max(peakBytes, queue.peakChargedBytes());
+        }
+        cout << "[AI BMT] Streaming: " << preprocessingThreads << " preprocessing thread(s), budget " << options.streamBudgetMb
+             << " MB, peak " << peakBytes / (1024.0 * 1024.0) << " MB in flight" << endl;
+        return measurement;
+    }
+
+    // Settings that turn the compact and encoded result modes of the ONNX Runtime examples off (Ort_Runtime_Config.h).
+    static vector<pair<string, string>> rawResultSettings()
+    {
+        return { { "detection_output", "raw" }, { "segmentation_output", "raw" }, { "result_encoding", "float32" } };
+    }
+
+    // --check-results: the first images in the configured result mode, then with rawResultSettings() exported on top
+    // of the model's settings, compared query by query. The implementation ends up re-initialized in its configured mode.
+    bool checkResults(const vector<string>& imagePaths, size_t count)
+    {
+        TraceSpan span("harness", "checkResults");
+        vector<VariantType> queries(min(count, imagePaths.size()));
+        for (size_t i = 0; i < queries.size(); ++i)
+            queries[i] = convertImage(imagePaths[i]);
+
+        vector<BMTResult> results = interface->runInference(queries);
+        if (results.size() != queries.size())
+            throw runtime_error("runInference returned " + to_string(results.size()) + " results for " + to_string(queries.size()) + " queries");
+        vector<BMTResultExtras> extras(results.size());
+        bool anyExtras = false;
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BMTResultExtras* found = findResultExtras(*interface, results[i]);
+            if (found != nullptr)
+                extras[i] = *found;
+            anyExtras = anyExtras || found != nullptr;
+        }
+        interface->releaseResults(results);
+        if (!anyExtras)
+        {
+            cout << "[AI BMT] Result check: the results are raw float32 already; nothing to compare" << endl;
+            return true;
+        }
+
+        vector<SavedSetting> saved;
+        for (const auto& setting : rawResultSettings())
+        {
+            saved.push_back(saveSetting(setting.first));
+            exportSetting(setting.first + "=" + setting.second);
+        }
+        interface->Initialize(modelPath);
+        vector<BMTResult> rawResults = interface->runInference(queries);
+        const vector<BMTResult> raw = rawResults; // The implementation may recycle the returned buffers
+        interface->releaseResults(rawResults);
+        for (const SavedSetting& setting : saved)
+            restoreSetting(setting);
+        interface->Initialize(modelPath);
+        if (raw.size() != queries.size())
+            throw runtime_error("runInference returned " + to_string(raw.size()) + " raw results for " + to_string(queries.size()) + " queries");
+
+        const BMTResultExtrasProvider* provider = dynamic_cast<const BMTResultExtrasProvider*>(interface.get());
+        ResultCheck check;
+        for (size_t i = 0; i < raw.size(); ++i)
+        {
+            vector<Coco17DetectionResult> expectedBoxes;
+            if (holdsBoxes(extras[i]) && provider != nullptr && provider->referenceBoxes(raw[i], expectedBoxes))
+                check.addBoxes(expectedBoxes, extras[i].objectDetectionBoxes);
+            if (!extras[i].segmentationClassMap.empty())
+                check.addClassMap(raw[i].segmentationResult, extras[i].segmentationClassMap);
+            if (!extras[i].objectDetectionResultEncoded.empty())
+                check.addEncoded(raw[i].objectDetectionResult, extras[i].objectDetectionResultEncoded);
+            if (!extras[i].segmentationResultEncoded.empty())
+                check.addEncoded(raw[i].segmentationResult, extras[i].segmentationResultEncoded);
+        }
+        cout << "[AI BMT] Result check: " << queries.size() << " queries against raw float32 results" << endl;
+        if (check.empty())
+            cout << "[AI BMT] Result check: no result mode of the implementation could be compared" << endl;
+        check.print(cout);
+        return check.passed();
+    }
+
+    static void printMeasurement(const Measurement& measurement, size_t batchSize, int iterations)
+    {
+        vector<double> callLatenciesMs = measurement.callLatenciesMs;
+        sort(callLatenciesMs.begin(), callLatenciesMs.end());
+        cout << "[AI BMT] Queries: " << measurement.queryCount << " (" << callLatenciesMs.size() / iterations << " runInference call(s) x " << iterations << " iteration(s), batch " << batchSize << ")" << endl;
+        cout << "[AI BMT] Total inference time: " << measurement.totalMs << " ms" << endl;
+        cout << "[AI BMT] runInference latency (ms): min " << callLatenciesMs.front()
+             << ", mean " << measurement.totalMs / callLatenciesMs.size()
+             << ", max " << callLatenciesMs.back() << endl;
+        cout << "[AI BMT] Mean latency per query: " << measurement.totalMs / measurement.queryCount << " ms" << endl;
+        cout << "[AI BMT] Throughput: " << measurement.queryCount / (measurement.totalMs / 1000.0) << " queries/s" << endl;
+        if (callLatenciesMs.size() < LatencyRecorder::MinPercentileSamples)
+            cout << "[AI BMT] Warning: " << callLatenciesMs.size() << " timed runInference call(s) are too few for latency percentiles; "
+                 << "use --batch 1 to time every query, or more --iterations" << endl;
+    }
+
+    static AutotuneDimension autotuneDimension(const string& key, const vector<size_t>& values)
+    {
+        AutotuneDimension dimension{ key, {} };
+        for (size_t value : values)
+            dimension.values.push_back({ { key, to_string(value) } });
+        return dimension;
+    }
+
+    int runAutotune(const vector<string>& imagePaths, const Options& options)
+    {
+        vector<VariantType> data = loadDataset(imagePaths, options);
+
+        const size_t hardwareThreads = max(1u, thread::hardware_concurrency());
+        vector<size_t> intraOpThreads = options.tuneIntraOpThreads;
+        if (intraOpThreads.empty())
+        {
+            for (size_t threads = 1; threads < hardwareThreads; threads *= 2)
+                intraOpThreads.push_back(threads);
+            intraOpThreads.push_back(hardwareThreads);
+        }
+        vector<size_t> batchSizes = options.tuneBatchSizes;
+        if (batchSizes.empty())
+        {
+            for (size_t batch = 1; batch <= 16 && batch <= data.size(); batch *= 2)
+                batchSizes.push_back(batch);
+        }
+
+        vector<AutotuneDimension> dimensions = { autotuneDimension("intra_op_threads", intraOpThreads) };
+        if (!options.tuneInterOpThreads.empty())
+        {
+            AutotuneDimension inter{ "inter_op_threads", {} };
+            for (size_t threads : options.tuneInterOpThreads)
+                inter.values.push_back({ { "execution_mode", threads == 0 ? "sequential" : "parallel" }, { "inter_op_threads", to_string(threads) } });
+            dimensions.push_back(inter);
+        }
+        dimensions.push_back(autotuneDimension("batch_size", batchSizes));
+        vector<size_t> sessionCounts = options.tuneSessionCounts;
+        if (sessionCounts.empty())
+        {
+            for (size_t sessions = 1; sessions <= 4 && sessions <= hardwareThreads; sessions *= 2)
+                sessionCounts.push_back(sessions);
+        }
+        dimensions.push_back(autotuneDimension("session_count", sessionCounts));
+
+        Autotuner tuner(*interface, modelPath, data, [this](const string& setting) { return exportSetting(setting); });
+        tuner.warmup = options.warmup;
+        tuner.iterations = options.iterations;
+        tuner.latencyBoundMs = options.scenario.latencyBoundMs;
+        vector<AutotuneResult> results = tuner.sweep(dimensions, cout);
+        const AutotuneResult* chosen = tuner.choose(results);
+        Autotuner::printResults(cout, results, chosen);
+        if (chosen == nullptr)
+        {
+            cerr << "No autotune point succeeded" << (options.scenario.latencyBoundMs > 0 ? " within the latency bound" : "") << endl;
+            return 1;
+        }
+        const string profilePath = autotuneProfilePath(modelPath);
+        Autotuner::writeProfile(profilePath, modelPath, *chosen);
+        cout << "[AI BMT] Autotune profile written to " << profilePath << ": " << chosen->label() << endl;
+        return 0;
+    }
+
+    void printReports(const Options& options)
+    {
+        LatencyRecorder::instance().printPercentiles(cout);
+        printStageBreakdown(cout);
+        HardwareCounterRecorder::instance().print(cout);
+        if (!options.latencyCsvPath.empty())
+            LatencyRecorder::instance().writeCsv(options.latencyCsvPath);
+        if (options.opProfileNodes > 0)
+        {
+            vector<ModelOperatorProfile> models = ModelOperatorProfile::summarize(TraceRecorder::instance().finishProfiles(), measurementStartNs);
+            if (models.empty())
+                cout << "[AI BMT] No ONNX Runtime profile was written; the implementation must read the \"profiling\" setting" << endl;
+            for (const ModelOperatorProfile& model : models)
+                model.print(cout, options.opProfileNodes);
+        }
+        if (!options.tracePath.empty())
+        {
+            TraceRecorder::instance().writeChromeTrace(options.tracePath);
+            cout << "[AI BMT] Trace written to " << options.tracePath << endl;
+        }
+    }
+
+public:
+    AI_BMT_CLI_CALLER(shared_ptr<AI_BMT_Interface> interface, string modelPath)
+        : interface(interface), modelPath(modelPath)
+    {
+    }
+
+    int call_BMT_CLI(int argc, char* argv[])
+    {
+        Options options;
+        if (!parseArguments(argc, argv, options))
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        vector<string> imagePaths = collectImagePaths(options.datasetDir, options.limit);
+        if (imagePaths.empty())
+        {
+            cerr << "No images found in: " << options.datasetDir << endl;
+            return 1;
+        }
+
+        cout << "[AI BMT] Model: " << modelPath << endl;
+        printOptionalData(interface->getOptionalData());
+
+        // Every model of the process is profiled, and the model under test even if its .cfg turns profiling off.
+        if (!options.tracePath.empty() || options.opProfileNodes > 0)
+        {
+            exportSetting("profiling=1", true);
+            exportSetting("profiling=1");
+        }
+        if (!options.tracePath.empty())
+            TraceRecorder::instance().enable();
+
+        auto initStart = chrono::steady_clock::now();
+        {
+            TraceSpan span("harness", "Initialize", modelPath);
+            interface->Initialize(modelPath);
+        }
+        auto initEnd = chrono::steady_clock::now();
+        cout << "[AI BMT] Initialize: " << elapsedMs(initStart, initEnd) << " ms" << endl;
+
+        if (options.checkResults > 0 && !checkResults(imagePaths, options.checkResults))
+        {
+            cerr << "Result check failed: the results differ from the raw float32 results of the same queries" << endl;
+            return 1;
+        }
+
+        // After Initialize, so the counters also cover the threads the implementation created.
+        if (options.hardwareCounters)
+        {
+            string reason;
+            if (!HardwareCounterRecorder::instance().enable(reason))
+                cout << "[AI BMT] Hardware counters unavailable (" << reason << "); continuing without them" << endl;
+            else if (!reason.empty())
+                cout << "[AI BMT] Hardware counters: " << reason << endl;
+        }
+
+        if (options.autotune)
+            return runAutotune(imagePaths, options);
+
+        if (options.runScenario)
+        {
+            vector<VariantType> data = loadDataset(imagePaths, options);
+            ScenarioSettings settings = options.scenario;
+            if (settings.scenario == BenchmarkScenario::Offline)
+                settings.maxBatch = options.batchSize;
+            else
+                settings.maxBatch = max<size_t>(1, options.batchSize);
+
+            const size_t warmupBatch = min(max<size_t>(1, settings.scenario == BenchmarkScenario::MultiStream ? settings.samplesPerQuery : settings.maxBatch), data.size());
+            vector<VariantType> warmupQueries(data.begin(), data.begin() + warmupBatch);
+            warmup(warmupQueries, options.warmup);
+            warmupQueries.clear();
+
+            ScenarioRunner runner(*interface, data, settings.seed);
+            runner.run(settings).print(cout);
+            printReports(options);
+            return 0;
+        }
+
+        Measurement measurement;
+        size_t batchSize;
+        if (options.streamBudgetMb > 0 && options.cachePath.empty())
+        {
+            batchSize = options.batchSize == 0 ? 1 : min(options.batchSize, imagePaths.size());
+            measurement = runStreaming(imagePaths, options, batchSize);
+        }
+        else
+        {
+            batchSize = options.batchSize == 0 ? imagePaths.size() : min(options.batchSize, imagePaths.size());
+            measurement = runInMemory(imagePaths, options, batchSize);
+        }
+        printMeasurement(measurement, batchSize, options.iterations);
+        resultOutput.print(cout);
+        printReports(options);
+        return 0;
+    }
+};
+
+#endif // AI_BMT_CLI_CALLER_H
@@ -0,0 +1,95 @@
+#ifndef AI_BMT_CPU_AFFINITY_H
+#define AI_BMT_CPU_AFFINITY_H
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+
+// Logical processors this process may run on (the cpuset on Linux, e.g., inside containers), in ascending order.
+inline vector<unsigned> availableCpus()
+{
+    vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        const unsigned count = max(1u, thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Splits the available processors into `count` contiguous groups of (nearly) equal size.
+// With more groups than processors, groups of one processor are reused round-robin.
+inline vector<vector<unsigned>> splitCpuGroups(size_t count)
+{
+    const vector<unsigned> cpus = availableCpus();
+    vector<vector<unsigned>> groups(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (count > cpus.size())
+        {
+            groups[i] = { cpus[i % cpus.size()] };
+            continue;
+        }
+        const size_t begin = cpus.size() * i / count;
+        const size_t end = cpus.size() * (i + 1) / count;
+        groups[i].assign(cpus.begin() + begin, cpus.begin() + end);
+    }
+    return groups;
+}
+
+// Restricts the calling thread to the given logical processors. Returns false where unsupported
+// (on Windows only processors of the first processor group, 0-63, can be used).
+inline bool pinCurrentThread(const vector<unsigned>& cpus)
+{
+    if (cpus.empty())
+        return false;
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (unsigned cpu : cpus)
+    {
+        if (cpu < sizeof(DWORD_PTR) * 8)
+            mask |= (DWORD_PTR)1 << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+#endif // AI_BMT_CPU_AFFINITY_H
@@ -0,0 +1,117 @@
+#ifndef AI_BMT_ENCODED_TENSOR_H
+#define AI_BMT_ENCODED_TENSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+// Output tensor stored in fewer bytes per element than vector<float>:
+//   Float16  IEEE 754 half precision, 2 bytes per element (the bit layout of Ort::Float16_t)
+//   Int8     real value = (value - zeroPoint) * scale, 1 byte per element
+// Read it through DequantizedView, which also accepts a plain vector<float>.
+struct EncodedTensor
+{
+    enum class Encoding : uint8_t { Float16, Int8 };
+
+    Encoding encoding = Encoding::Float16;
+    vector<uint16_t> float16Data;
+    vector<int8_t> int8Data;
+    float scale = 1.0f;
+    int32_t zeroPoint = 0;
+
+    size_t size() const { return encoding == Encoding::Float16 ? float16Data.size() : int8Data.size(); }
+    bool empty() const { return size() == 0; }
+};
+
+// Exact half -> float conversion, including subnormals, infinities and NaN.
+inline float halfToFloat(uint16_t half)
+{
+    const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0x1F)
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else if (mantissa == 0)
+        bits = sign;
+    else
+    {
+        // Subnormal: normalize the mantissa.
+        exponent = 113;
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Read-only float view of a result, whether stored as vector<float> or as an EncodedTensor.
+// The viewed storage must outlive the view.
+class DequantizedView
+{
+private:
+    const float* floatData = nullptr;
+    const uint16_t* float16Data = nullptr;
+    const int8_t* int8Data = nullptr;
+    size_t count = 0;
+    float scale = 1.0f;
+    int32_t zeroPoint = 0;
+
+public:
+    DequantizedView(const vector<float>& data) : floatData(data.data()), count(data.size()) {}
+
+    DequantizedView(const EncodedTensor& tensor) : count(tensor.size()), scale(tensor.scale), zeroPoint(tensor.zeroPoint)
+    {
+        if (tensor.encoding == EncodedTensor::Encoding::Float16)
+            float16Data = tensor.float16Data.data();
+        else
+            int8Data = tensor.int8Data.data();
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    float operator[](size_t index) const
+    {
+        if (floatData != nullptr)
+            return floatData[index];
+        if (float16Data != nullptr)
+            return halfToFloat(float16Data[index]);
+        return (int8Data[index] - zeroPoint) * scale;
+    }
+
+    // Dequantizes elements [begin, begin + length) into output.
+    void copyTo(size_t begin, size_t length, float* output) const
+    {
+        if (floatData != nullptr)
+            memcpy(output, floatData + begin, length * sizeof(float));
+        else if (float16Data != nullptr)
+        {
+            for (size_t i = 0; i < length; ++i)
+                output[i] = halfToFloat(float16Data[begin + i]);
+        }
+        else
+        {
+            for (size_t i = 0; i < length; ++i)
+                output[i] = (int8Data[begin + i] - zeroPoint) * scale;
+        }
+    }
+
+    vector<float> toVector() const
+    {
+        vector<float> values(count);
+        copyTo(0, count, values.data());
+        return values;
+    }
+};
+
+#endif // AI_BMT_ENCODED_TENSOR_H
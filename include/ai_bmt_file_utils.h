@@ -0,0 +1,194 @@
+#ifndef AI_BMT_FILE_UTILS_H
+#define AI_BMT_FILE_UTILS_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// File, hash, host and setting-name helpers shared by the command-line driver and the submitter-side ONNX Runtime code.
+
+// Memory-mapped file, either an existing file mapped read-only or a new file of a fixed size mapped read-write.
+class MappedFile
+{
+private:
+    uint8_t* mappedData = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    void map(const string& path, size_t size, bool writable)
+    {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, nullptr,
+            writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            throw runtime_error("Failed to open " + path);
+        if (!writable)
+        {
+            LARGE_INTEGER fileSize;
+            GetFileSizeEx(fileHandle, &fileSize);
+            size = (size_t)fileSize.QuadPart;
+        }
+        mappedSize = size;
+        if (size == 0)
+            return;
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+            (DWORD)((uint64_t)size >> 32), (DWORD)((uint64_t)size & 0xFFFFFFFF), nullptr);
+        if (mappingHandle == nullptr)
+            throw runtime_error("Failed to map " + path);
+        mappedData = (uint8_t*)MapViewOfFile(mappingHandle, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+        if (mappedData == nullptr)
+            throw runtime_error("Failed to map " + path);
+#else
+        fileDescriptor = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+        if (fileDescriptor < 0)
+            throw runtime_error("Failed to open " + path);
+        if (writable)
+        {
+            if (ftruncate(fileDescriptor, (off_t)size) != 0)
+                throw runtime_error("Failed to resize " + path);
+        }
+        else
+        {
+            struct stat fileStat;
+            fstat(fileDescriptor, &fileStat);
+            size = (size_t)fileStat.st_size;
+        }
+        mappedSize = size;
+        if (size == 0)
+            return;
+        void* address = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        if (address == MAP_FAILED)
+            throw runtime_error("Failed to map " + path);
+        mappedData = (uint8_t*)address;
+#endif
+    }
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    void openReadOnly(const string& path) { map(path, 0, false); }
+    void createReadWrite(const string& path, size_t size) { map(path, size, true); }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (mappedData != nullptr)
+            UnmapViewOfFile(mappedData);
+        if (mappingHandle != nullptr)
+            CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (mappedData != nullptr)
+            munmap(mappedData, mappedSize);
+        if (fileDescriptor >= 0)
+            ::close(fileDescriptor);
+        fileDescriptor = -1;
+#endif
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+
+    uint8_t* data() { return mappedData; }
+    const uint8_t* data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+};
+
+// FNV-1a 64-bit hash of a file's content.
+inline uint64_t hashFile(const string& path, uint64_t& fileSize)
+{
+    ifstream stream(path, ios::binary);
+    if (!stream)
+        throw runtime_error("Failed to read " + path);
+    uint64_t hash = 1469598103934665603ull;
+    vector<char> buffer(1 << 16);
+    fileSize = 0;
+    while (stream)
+    {
+        stream.read(buffer.data(), buffer.size());
+        streamsize count = stream.gcount();
+        for (streamsize i = 0; i < count; ++i)
+        {
+            hash ^= (uint8_t)buffer[i];
+            hash *= 1099511628211ull;
+        }
+        fileSize += (uint64_t)count;
+    }
+    return hash;
+}
+
+// Machine name used in per-host file names (autotune profiles, optimized model caches),
+// reduced to characters that are safe in a path.
+inline string autotuneHostName()
+{
+    string name;
+#ifdef _WIN32
+    const char* computerName = getenv("COMPUTERNAME");
+    if (computerName != nullptr)
+        name = computerName;
+#else
+    char buffer[256] = {};
+    if (gethostname(buffer, sizeof(buffer) - 1) == 0)
+        name = buffer;
+#endif
+    for (char& c : name)
+    {
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_' && c != '.')
+            c = '_';
+    }
+    return name.empty() ? "localhost" : name;
+}
+
+// Per-machine profile written by the autotuner and loaded by the runtime config of the implementations.
+inline string autotuneProfilePath(const string& modelPath)
+{
+    return modelPath + "." + autotuneHostName() + ".autotune";
+}
+
+// Environment variable of runtime setting `key` (e.g., "batch_size"): "AI_BMT_<KEY>" applies to every model of the
+// process, "AI_BMT_<MODEL STEM>_<KEY>" only to the model at modelPath (e.g., AI_BMT_YOLOV5N_OPSET12_BATCH_SIZE for
+// Yolov5n_opset12.onnx). Characters other than letters and digits become '_'.
+inline string settingEnvironmentName(const string& key, const string& modelPath = "")
+{
+    string name = "AI_BMT_";
+    if (!modelPath.empty())
+        name += filesystem::path(modelPath).stem().string() + "_";
+    name += key;
+    for (char& c : name)
+        c = isalnum((unsigned char)c) ? (char)toupper((unsigned char)c) : '_';
+    return name;
+}
+
+#endif // AI_BMT_FILE_UTILS_H
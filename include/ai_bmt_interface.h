@@ -7,9 +7,17 @@
 #else //Linux(.so) and other operating systems
 #define EXPORT_SYMBOL
 #endif
+// Builds driven by the command-line caller (ai_bmt_cli_caller.h) instead of the prebuilt GUI library, which shares
+// the layout of the types below and cannot see anything added for the command-line caller alone.
+#if !defined(_WIN32) || defined(AI_BMT_HEADLESS)
+#define AI_BMT_CLI_BUILD
+#endif
 #include <vector>
 #include <iostream>
 #include <variant>
+#include <memory>
+#include <string>
+#include <stdexcept>
 #include <cstdint>//To ensure the Submitter side recognizes the uint8_t type in VariantType, this header must be included.
 #include "label_type.h"
 
@@ -59,6 +67,130 @@ struct EXPORT_SYMBOL Optional_Data
     string operating_system; // e.g., Ubuntu 20.04.5 LTS
 };
 
+#ifdef AI_BMT_CLI_BUILD
+// Element type of a TensorView.
+enum class TensorDataType : uint8_t
+{
+    UInt8, UInt16, UInt32,
+    Int8, Int16, Int32,
+    Float32,
+    Float16 // IEEE 754 half precision held as uint16_t (borrow/wrap uint16_t data, then set dtype)
+};
+
+// Self-describing input tensor for VariantType: unlike vector<T> or T*, it carries the shape of the query, so the
+// implementation can check or bind it without hard-coding {3, 224, 224} and the like, and says whether it owns its memory.
+// Command-line driver only (AI_BMT_CLI_BUILD): the prebuilt GUI library shares the layout of VariantType, so GUI builds
+// keep returning vector<T> from convertToPreprocessedDataForInference(..).
+//   data       first element
+//   shape      one query without the batch dimension, e.g., {3, 640, 640}
+//   strides    in elements per dimension; empty means contiguous row-major
+//   alignment  guaranteed alignment of data in bytes (computed from the address by the factory functions)
+//   owner      keeps the memory alive while any copy of the view exists; empty for borrowed memory
+struct TensorView
+{
+    void* data = nullptr;
+    TensorDataType dtype = TensorDataType::Float32;
+    vector<int64_t> shape;
+    vector<int64_t> strides;
+    size_t alignment = 0;
+    shared_ptr<void> owner;
+
+    static size_t elementSize(TensorDataType type)
+    {
+        switch (type)
+        {
+        case TensorDataType::UInt8: case TensorDataType::Int8: return 1;
+        case TensorDataType::UInt16: case TensorDataType::Int16: case TensorDataType::Float16: return 2;
+        default: return 4;
+        }
+    }
+
+    template <typename T> static TensorDataType dataTypeOf();
+
+    // Largest power of two (up to 4096) dividing the address.
+    static size_t alignmentOf(const void* pointer)
+    {
+        const uintptr_t address = (uintptr_t)pointer;
+        size_t alignment = 1;
+        while (alignment < 4096 && (address & alignment) == 0)
+            alignment <<= 1;
+        return alignment;
+    }
+
+    size_t elementCount() const
+    {
+        size_t count = 1;
+        for (int64_t dim : shape)
+            count *= (size_t)dim;
+        return count;
+    }
+
+    size_t byteCount() const { return elementCount() * elementSize(dtype); }
+
+    bool isContiguous() const
+    {
+        if (strides.empty())
+            return true;
+        if (strides.size() != shape.size())
+            return false;
+        int64_t expected = 1;
+        for (size_t i = shape.size(); i-- > 0;)
+        {
+            if (shape[i] != 1 && strides[i] != expected)
+                return false;
+            expected *= shape[i];
+        }
+        return true;
+    }
+
+    bool ownsData() const { return owner != nullptr; }
+
+    // Takes ownership of values (moved, not copied). The usual way to return a preprocessed query with its shape:
+    //   return TensorView::wrap(move(output), { 3, image.rows, image.cols });
+    // The runner then checks the shape against the model instead of only counting elements.
+    template <typename T>
+    static TensorView wrap(vector<T>&& values, vector<int64_t> shape)
+    {
+        auto storage = make_shared<vector<T>>(move(values));
+        TensorView view = borrow(storage->data(), move(shape));
+        if (view.elementCount() != storage->size())
+            throw runtime_error("TensorView shape does not match the number of elements");
+        view.owner = move(storage);
+        return view;
+    }
+
+    // Refers to memory owned elsewhere, which must outlive every copy of the view.
+    template <typename T>
+    static TensorView borrow(T* data, vector<int64_t> shape)
+    {
+        TensorView view;
+        view.data = (void*)data;
+        view.dtype = dataTypeOf<T>();
+        view.shape = move(shape);
+        view.alignment = alignmentOf(data);
+        return view;
+    }
+
+    // Takes ownership of data, released with deleter (e.g., an aligned free or an accelerator's buffer release)
+    // once the last copy of the view is gone.
+    template <typename T, typename Deleter>
+    static TensorView adopt(T* data, vector<int64_t> shape, Deleter deleter)
+    {
+        TensorView view = borrow(data, move(shape));
+        view.owner = shared_ptr<void>((void*)data, [deleter](void* pointer) mutable { deleter((T*)pointer); });
+        return view;
+    }
+};
+
+template <> inline TensorDataType TensorView::dataTypeOf<uint8_t>() { return TensorDataType::UInt8; }
+template <> inline TensorDataType TensorView::dataTypeOf<uint16_t>() { return TensorDataType::UInt16; }
+template <> inline TensorDataType TensorView::dataTypeOf<uint32_t>() { return TensorDataType::UInt32; }
+template <> inline TensorDataType TensorView::dataTypeOf<int8_t>() { return TensorDataType::Int8; }
+template <> inline TensorDataType TensorView::dataTypeOf<int16_t>() { return TensorDataType::Int16; }
+template <> inline TensorDataType TensorView::dataTypeOf<int32_t>() { return TensorDataType::Int32; }
+template <> inline TensorDataType TensorView::dataTypeOf<float>() { return TensorDataType::Float32; }
+#endif
+
 // A variant can store and manage values only from a fixed set of types determined at compile time.
 // Since variant manages types statically, it can be used with minimal runtime type-checking overhead.
 // std::get<DataType>(variant) checks if the requested type matches the stored type and returns the value if they match.
@@ -75,6 +207,11 @@ using VariantType = variant<
 
     // Python object (e.g., numpy.ndarray, torch.Tensor, etc.)
     PythonObject
+#ifdef AI_BMT_CLI_BUILD
+    ,
+    // Tensor with shape, strides, alignment and ownership; appended so the other alternatives keep their index
+    TensorView
+#endif
     >;
 
 class EXPORT_SYMBOL AI_BMT_Interface
@@ -115,6 +252,26 @@ public:
 
    // Returns the final BMTResult value of the query required for performance evaluation in the App.
    virtual vector<BMTResult> runInference(const vector<VariantType>& data) = 0;
+
+   // This is not mandatory but can be implemented if needed.
+   // Called by the caller outside of the measured region once it no longer needs the results of runInference(..).
+   // Implementations may move the result buffers back into their own pool so the next runInference(..) does not allocate.
+   // Callers pass the vector runInference(..) returned, neither copied nor moved from, before the next runInference(..):
+   // implementations may keep per-result state keyed by the address of each BMTResult (see ai_bmt_result_extras.h),
+   // valid until this call or the next runInference(..), whichever comes first.
+   virtual void releaseResults(vector<BMTResult>& /*results*/) {}
+
+   // This is not mandatory but can be implemented if needed.
+   // Return true if convertToPreprocessedDataForInference(..) may be called concurrently from multiple threads
+   // (e.g., it only reads its argument, constants and member variables set in Initialize). The caller may then preprocess
+   // the dataset in parallel.
+   // By default, preprocessing is called from a single thread.
+   virtual bool isPreprocessingThreadSafe() { return false; }
+
+   // This is not mandatory but can be implemented if needed.
+   // Describes the preprocessing parameters (e.g., input size, channel order, mean/std).
+   // Stored with caches of preprocessed data, so a cache built with different parameters is rebuilt instead of reused.
+   virtual string getPreprocessingSignature() { return ""; }
 };
 
 #endif // AI_BMT_INTERFACE_H
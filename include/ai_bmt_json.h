@@ -0,0 +1,335 @@
+#ifndef AI_BMT_JSON_H
+#define AI_BMT_JSON_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Minimal JSON value with a reader and a writer, enough for ONNX Runtime profile files and Chrome traces.
+struct JsonValue
+{
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    string text;
+    vector<JsonValue> items;                  // Array
+    vector<pair<string, JsonValue>> members;  // Object, in document order
+
+    bool isObject() const { return type == Type::Object; }
+    bool isArray() const { return type == Type::Array; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isString() const { return type == Type::String; }
+
+    const JsonValue* find(const string& key) const
+    {
+        for (const auto& member : members)
+        {
+            if (member.first == key)
+                return &member.second;
+        }
+        return nullptr;
+    }
+
+    JsonValue* find(const string& key)
+    {
+        return const_cast<JsonValue*>(static_cast<const JsonValue*>(this)->find(key));
+    }
+
+    string stringOr(const string& key, const string& fallback) const
+    {
+        const JsonValue* value = find(key);
+        return value && value->isString() ? value->text : fallback;
+    }
+
+    double numberOr(const string& key, double fallback) const
+    {
+        const JsonValue* value = find(key);
+        return value && value->isNumber() ? value->number : fallback;
+    }
+
+    static JsonValue makeNumber(double value)
+    {
+        JsonValue json;
+        json.type = Type::Number;
+        json.number = value;
+        return json;
+    }
+
+    static JsonValue makeString(const string& value)
+    {
+        JsonValue json;
+        json.type = Type::String;
+        json.text = value;
+        return json;
+    }
+
+    static JsonValue makeObject()
+    {
+        JsonValue json;
+        json.type = Type::Object;
+        return json;
+    }
+
+    void set(const string& key, JsonValue value)
+    {
+        if (JsonValue* existing = find(key))
+            *existing = move(value);
+        else
+            members.emplace_back(key, move(value));
+    }
+};
+
+class JsonReader
+{
+private:
+    const string& source;
+    size_t position = 0;
+
+    [[noreturn]] void fail(const string& message) const
+    {
+        throw runtime_error("JSON parse error at offset " + to_string(position) + ": " + message);
+    }
+
+    void skipWhitespace()
+    {
+        while (position < source.size() && (source[position] == ' ' || source[position] == '\t' || source[position] == '\n' || source[position] == '\r'))
+            ++position;
+    }
+
+    bool consume(char expected)
+    {
+        skipWhitespace();
+        if (position < source.size() && source[position] == expected)
+        {
+            ++position;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char expected)
+    {
+        if (!consume(expected))
+            fail(string("expected '") + expected + "'");
+    }
+
+    static void appendUtf8(string& out, unsigned codePoint)
+    {
+        if (codePoint < 0x80)
+            out += (char)codePoint;
+        else if (codePoint < 0x800)
+        {
+            out += (char)(0xC0 | (codePoint >> 6));
+            out += (char)(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xE0 | (codePoint >> 12));
+            out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            out += (char)(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    string parseString()
+    {
+        expect('"');
+        string out;
+        while (position < source.size() && source[position] != '"')
+        {
+            char c = source[position++];
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (position >= source.size())
+                fail("unterminated escape");
+            char escape = source[position++];
+            switch (escape)
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+                if (position + 4 > source.size())
+                    fail("truncated \\u escape");
+                appendUtf8(out, (unsigned)strtoul(source.substr(position, 4).c_str(), nullptr, 16));
+                position += 4;
+                break;
+            default: fail("invalid escape");
+            }
+        }
+        if (position >= source.size())
+            fail("unterminated string");
+        ++position;
+        return out;
+    }
+
+    JsonValue parseValue()
+    {
+        skipWhitespace();
+        if (position >= source.size())
+            fail("unexpected end");
+        JsonValue value;
+        char c = source[position];
+        if (c == '{')
+        {
+            ++position;
+            value.type = JsonValue::Type::Object;
+            if (consume('}'))
+                return value;
+            do {
+                skipWhitespace();
+                string key = parseString();
+                expect(':');
+                value.members.emplace_back(move(key), parseValue());
+            } while (consume(','));
+            expect('}');
+        }
+        else if (c == '[')
+        {
+            ++position;
+            value.type = JsonValue::Type::Array;
+            if (consume(']'))
+                return value;
+            do {
+                value.items.push_back(parseValue());
+            } while (consume(','));
+            expect(']');
+        }
+        else if (c == '"')
+        {
+            value.type = JsonValue::Type::String;
+            value.text = parseString();
+        }
+        else if (source.compare(position, 4, "true") == 0 || source.compare(position, 5, "false") == 0)
+        {
+            value.type = JsonValue::Type::Bool;
+            value.boolean = c == 't';
+            position += value.boolean ? 4 : 5;
+        }
+        else if (source.compare(position, 4, "null") == 0)
+        {
+            position += 4;
+        }
+        else
+        {
+            const char* begin = source.c_str() + position;
+            char* end = nullptr;
+            value.type = JsonValue::Type::Number;
+            value.number = strtod(begin, &end);
+            if (end == begin)
+                fail("unexpected character");
+            position += (size_t)(end - begin);
+        }
+        return value;
+    }
+
+public:
+    explicit JsonReader(const string& source) : source(source) {}
+
+    JsonValue parse()
+    {
+        JsonValue value = parseValue();
+        skipWhitespace();
+        if (position != source.size())
+            fail("trailing characters");
+        return value;
+    }
+
+    static JsonValue parseFile(const string& path)
+    {
+        ifstream file(path, ios::binary);
+        if (!file)
+            throw runtime_error("Failed to read " + path);
+        stringstream buffer;
+        buffer << file.rdbuf();
+        const string source = buffer.str();
+        return JsonReader(source).parse();
+    }
+};
+
+class JsonWriter
+{
+public:
+    static void writeString(ostream& out, const string& text)
+    {
+        out << '"';
+        for (unsigned char c : text)
+        {
+            switch (c)
+            {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (c < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out << escaped;
+                }
+                else
+                    out << c;
+            }
+        }
+        out << '"';
+    }
+
+    static void writeNumber(ostream& out, double number)
+    {
+        char formatted[32];
+        snprintf(formatted, sizeof(formatted), "%.17g", number);
+        out << formatted;
+    }
+
+    static void write(ostream& out, const JsonValue& value)
+    {
+        switch (value.type)
+        {
+        case JsonValue::Type::Null: out << "null"; break;
+        case JsonValue::Type::Bool: out << (value.boolean ? "true" : "false"); break;
+        case JsonValue::Type::Number: writeNumber(out, value.number); break;
+        case JsonValue::Type::String: writeString(out, value.text); break;
+        case JsonValue::Type::Array:
+            out << '[';
+            for (size_t i = 0; i < value.items.size(); ++i)
+            {
+                if (i > 0)
+                    out << ',';
+                write(out, value.items[i]);
+            }
+            out << ']';
+            break;
+        case JsonValue::Type::Object:
+            out << '{';
+            for (size_t i = 0; i < value.members.size(); ++i)
+            {
+                if (i > 0)
+                    out << ',';
+                writeString(out, value.members[i].first);
+                out << ':';
+                write(out, value.members[i].second);
+            }
+            out << '}';
+            break;
+        }
+    }
+};
+
+#endif // AI_BMT_JSON_H
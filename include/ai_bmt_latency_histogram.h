@@ -0,0 +1,265 @@
+#ifndef AI_BMT_LATENCY_HISTOGRAM_H
+#define AI_BMT_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+using namespace std;
+
+// High-dynamic-range latency histogram with nanosecond resolution (HdrHistogram-style log-linear buckets).
+// Values below 256 ns are exact; above that every power-of-two range is split into 128 sub-buckets,
+// so any recorded value is reported within 0.8% (values up to 2^48 ns, about 78 hours).
+// record() is lock-free and wait-free apart from the min/max updates, so it can be called from any thread on hot paths.
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 8;
+    static constexpr uint64_t SubBucketCount = 1ull << SubBucketBits;
+    static constexpr uint64_t HalfSubBucketCount = SubBucketCount / 2;
+    static constexpr int MaxValueBits = 48;
+    static constexpr size_t BucketCount = SubBucketCount + (MaxValueBits - SubBucketBits) * HalfSubBucketCount;
+
+private:
+    atomic<uint64_t> buckets[BucketCount];
+    atomic<uint64_t> totalCount{ 0 };
+    atomic<uint64_t> totalNs{ 0 };
+    atomic<uint64_t> minimumNs{ UINT64_MAX };
+    atomic<uint64_t> maximumNs{ 0 };
+
+    static int highestBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return (int)index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static size_t bucketIndex(uint64_t ns)
+    {
+        if (ns < SubBucketCount)
+            return (size_t)ns;
+        ns = min<uint64_t>(ns, (1ull << MaxValueBits) - 1);
+        const int exponent = highestBit(ns) - SubBucketBits + 1;
+        const uint64_t mantissa = ns >> exponent; // [HalfSubBucketCount, SubBucketCount)
+        return (size_t)(SubBucketCount + (exponent - 1) * HalfSubBucketCount + (mantissa - HalfSubBucketCount));
+    }
+
+    // Largest value that maps to the bucket, as HdrHistogram reports percentiles.
+    static uint64_t highestEquivalentNs(size_t index)
+    {
+        if (index < SubBucketCount)
+            return (uint64_t)index;
+        const uint64_t exponent = (index - SubBucketCount) / HalfSubBucketCount + 1;
+        const uint64_t mantissa = (index - SubBucketCount) % HalfSubBucketCount + HalfSubBucketCount;
+        return ((mantissa + 1) << exponent) - 1;
+    }
+
+public:
+    LatencyHistogram() { reset(); }
+
+    // Snapshot of another histogram (which may still be recording).
+    LatencyHistogram(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < BucketCount; ++i)
+            buckets[i].store(other.buckets[i].load(memory_order_relaxed), memory_order_relaxed);
+        totalCount.store(other.totalCount.load());
+        totalNs.store(other.totalNs.load());
+        minimumNs.store(other.minimumNs.load());
+        maximumNs.store(other.maximumNs.load());
+    }
+
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t ns)
+    {
+        buckets[bucketIndex(ns)].fetch_add(1, memory_order_relaxed);
+        totalCount.fetch_add(1, memory_order_relaxed);
+        totalNs.fetch_add(ns, memory_order_relaxed);
+        uint64_t current = minimumNs.load(memory_order_relaxed);
+        while (ns < current && !minimumNs.compare_exchange_weak(current, ns, memory_order_relaxed)) {}
+        current = maximumNs.load(memory_order_relaxed);
+        while (ns > current && !maximumNs.compare_exchange_weak(current, ns, memory_order_relaxed)) {}
+    }
+
+    template <typename Rep, typename Period>
+    void record(chrono::duration<Rep, Period> duration)
+    {
+        int64_t ns = chrono::duration_cast<chrono::nanoseconds>(duration).count();
+        record((uint64_t)max<int64_t>(ns, 0));
+    }
+
+    // Not safe to call while other threads are recording.
+    void reset()
+    {
+        for (atomic<uint64_t>& bucket : buckets)
+            bucket.store(0, memory_order_relaxed);
+        totalCount.store(0);
+        totalNs.store(0);
+        minimumNs.store(UINT64_MAX);
+        maximumNs.store(0);
+    }
+
+    uint64_t count() const { return totalCount.load(memory_order_relaxed); }
+    uint64_t minNs() const { return count() == 0 ? 0 : minimumNs.load(memory_order_relaxed); }
+    uint64_t maxNs() const { return maximumNs.load(memory_order_relaxed); }
+    uint64_t sumNs() const { return totalNs.load(memory_order_relaxed); }
+    double meanNs() const { return count() == 0 ? 0 : (double)totalNs.load(memory_order_relaxed) / count(); }
+
+    // Nearest-rank percentile, p in [0, 100].
+    uint64_t percentileNs(double p) const
+    {
+        const uint64_t total = count();
+        if (total == 0)
+            return 0;
+        uint64_t rank = (uint64_t)ceil(p / 100.0 * total);
+        rank = min(max<uint64_t>(rank, 1), total);
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            cumulative += buckets[i].load(memory_order_relaxed);
+            if (cumulative >= rank)
+                return min(max(highestEquivalentNs(i), minNs()), maxNs());
+        }
+        return maxNs();
+    }
+};
+
+// Process-wide set of named histograms, e.g., one per query and one per inference stage.
+// Look a histogram up once (the reference stays valid for the process lifetime) and record() on it from hot paths.
+class LatencyRecorder
+{
+private:
+    mutable mutex registryMutex;
+    vector<pair<string, unique_ptr<LatencyHistogram>>> histograms; // In order of first use
+
+    LatencyRecorder() = default;
+
+public:
+    static LatencyRecorder& instance()
+    {
+        static LatencyRecorder recorder;
+        return recorder;
+    }
+
+    LatencyHistogram& histogram(const string& name)
+    {
+        lock_guard<mutex> lock(registryMutex);
+        for (auto& entry : histograms)
+        {
+            if (entry.first == name)
+                return *entry.second;
+        }
+        histograms.emplace_back(name, make_unique<LatencyHistogram>());
+        return *histograms.back().second;
+    }
+
+    // Clears every histogram, e.g., after warm-up. Not safe to call while other threads are recording.
+    void reset()
+    {
+        lock_guard<mutex> lock(registryMutex);
+        for (auto& entry : histograms)
+            entry.second->reset();
+    }
+
+    // Names and histograms in order of first use. The pointers stay valid for the process lifetime.
+    vector<pair<string, const LatencyHistogram*>> snapshot() const
+    {
+        lock_guard<mutex> lock(registryMutex);
+        vector<pair<string, const LatencyHistogram*>> entries;
+        for (const auto& entry : histograms)
+            entries.emplace_back(entry.first, entry.second.get());
+        return entries;
+    }
+
+    // Below this many samples, tail percentiles (p99 and up) are a single value or two and mean little.
+    static constexpr uint64_t MinPercentileSamples = 100;
+
+    static const vector<double>& exportedPercentiles()
+    {
+        static const vector<double> percentiles = { 50, 90, 99, 99.9 };
+        return percentiles;
+    }
+
+    // Percentile table (microseconds) of every histogram that recorded at least one value,
+    // followed by a note naming the histograms with fewer than MinPercentileSamples values.
+    void printPercentiles(ostream& out) const
+    {
+        lock_guard<mutex> lock(registryMutex);
+        const ios::fmtflags flags = out.flags();
+        const streamsize precision = out.precision();
+        out << "[AI BMT] Latency percentiles (us):" << endl;
+        out << "[AI BMT]   " << left << setw(24) << "stage" << right << setw(10) << "count" << setw(12) << "min";
+        for (double p : exportedPercentiles())
+            out << setw(12) << ("p" + formatPercentile(p));
+        out << setw(12) << "max" << setw(12) << "mean" << endl;
+        string fewSamples;
+        for (const auto& entry : histograms)
+        {
+            const LatencyHistogram& histogram = *entry.second;
+            if (histogram.count() == 0)
+                continue;
+            if (histogram.count() < MinPercentileSamples)
+                fewSamples += (fewSamples.empty() ? "" : ", ") + entry.first + " (" + to_string(histogram.count()) + ")";
+            out << "[AI BMT]   " << left << setw(24) << entry.first << right << setw(10) << histogram.count()
+                << fixed << setprecision(1) << setw(12) << histogram.minNs() / 1000.0;
+            for (double p : exportedPercentiles())
+                out << setw(12) << histogram.percentileNs(p) / 1000.0;
+            out << setw(12) << histogram.maxNs() / 1000.0 << setw(12) << histogram.meanNs() / 1000.0 << endl;
+        }
+        if (!fewSamples.empty())
+            out << "[AI BMT]   Warning: fewer than " << MinPercentileSamples << " samples in " << fewSamples << "; their tail percentiles are not meaningful." << endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // Same table as CSV: stage,count,min_us,p50_us,...,max_us,mean_us
+    void writeCsv(const string& path) const
+    {
+        ofstream file(path);
+        if (!file)
+            throw runtime_error("Failed to write " + path);
+        lock_guard<mutex> lock(registryMutex);
+        file << "stage,count,min_us";
+        for (double p : exportedPercentiles())
+            file << ",p" << formatPercentile(p) << "_us";
+        file << ",max_us,mean_us" << endl;
+        for (const auto& entry : histograms)
+        {
+            const LatencyHistogram& histogram = *entry.second;
+            if (histogram.count() == 0)
+                continue;
+            file << entry.first << "," << histogram.count() << "," << histogram.minNs() / 1000.0;
+            for (double p : exportedPercentiles())
+                file << "," << histogram.percentileNs(p) / 1000.0;
+            file << "," << histogram.maxNs() / 1000.0 << "," << histogram.meanNs() / 1000.0 << endl;
+        }
+    }
+
+    static string formatPercentile(double p)
+    {
+        string text = to_string(p);
+        text.erase(text.find_last_not_of('0') + 1);
+        if (text.back() == '.')
+            text.pop_back();
+        return text;
+    }
+};
+
+#endif // AI_BMT_LATENCY_HISTOGRAM_H
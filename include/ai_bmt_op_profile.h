@@ -0,0 +1,131 @@
+#ifndef AI_BMT_OP_PROFILE_H
+#define AI_BMT_OP_PROFILE_H
+
+#include "ai_bmt_json.h"
+#include "ai_bmt_trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Time spent in one graph node (or, aggregated, in one operator type) of a model.
+struct OperatorStats
+{
+    string opType;
+    string node; // Empty for operator type totals
+    uint64_t calls = 0;
+    double totalUs = 0;
+};
+
+// Per-model hotspot summary of the ONNX Runtime profiles: node kernel times summed over the measured runs.
+struct ModelOperatorProfile
+{
+    string modelName;
+    double totalUs = 0;           // Sum of all node kernel times
+    vector<OperatorStats> nodes;   // Descending by totalUs
+    vector<OperatorStats> opTypes; // Descending by totalUs
+
+    // Aggregates the "Node" events ("<node>_kernel_time", args.op_name) of every profile, grouped by model name.
+    // Events that started before sinceNs (e.g., warm-up runs) are skipped; unreadable profiles are reported and skipped.
+    static vector<ModelOperatorProfile> summarize(const vector<OrtProfileFile>& profiles, int64_t sinceNs = 0)
+    {
+        const string suffix = "_kernel_time";
+        vector<ModelOperatorProfile> models;
+        map<string, map<string, OperatorStats>> nodesByModel;
+        for (const OrtProfileFile& profile : profiles)
+        {
+            JsonValue events;
+            try {
+                events = JsonReader::parseFile(profile.path);
+            }
+            catch (const exception& e) {
+                cerr << "Warning: skipping ONNX Runtime profile " << profile.path << ": " << e.what() << endl;
+                continue;
+            }
+            map<string, OperatorStats>& nodes = nodesByModel[profile.modelName];
+            for (const JsonValue& event : events.items)
+            {
+                if (!event.isObject() || event.stringOr("cat", "") != "Node")
+                    continue;
+                const string name = event.stringOr("name", "");
+                if (name.size() <= suffix.size() || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+                    continue; // Fence events
+                if (profile.startNs + (int64_t)(event.numberOr("ts", 0) * 1000.0) < sinceNs)
+                    continue;
+                OperatorStats& stats = nodes[name.substr(0, name.size() - suffix.size())];
+                if (stats.node.empty())
+                {
+                    stats.node = name.substr(0, name.size() - suffix.size());
+                    const JsonValue* args = event.find("args");
+                    stats.opType = args ? args->stringOr("op_name", "?") : "?";
+                }
+                ++stats.calls;
+                stats.totalUs += event.numberOr("dur", 0);
+            }
+        }
+
+        auto byTime = [](const OperatorStats& a, const OperatorStats& b) { return a.totalUs > b.totalUs; };
+        for (auto& model : nodesByModel)
+        {
+            ModelOperatorProfile summary;
+            summary.modelName = model.first;
+            map<string, OperatorStats> opTypes;
+            for (auto& node : model.second)
+            {
+                OperatorStats& opType = opTypes[node.second.opType];
+                opType.opType = node.second.opType;
+                opType.calls += node.second.calls;
+                opType.totalUs += node.second.totalUs;
+                summary.totalUs += node.second.totalUs;
+                summary.nodes.push_back(move(node.second));
+            }
+            for (auto& opType : opTypes)
+                summary.opTypes.push_back(move(opType.second));
+            sort(summary.nodes.begin(), summary.nodes.end(), byTime);
+            sort(summary.opTypes.begin(), summary.opTypes.end(), byTime);
+            models.push_back(move(summary));
+        }
+        return models;
+    }
+
+    // Operator type totals followed by the topNodes most expensive nodes.
+    void print(ostream& out, size_t topNodes) const
+    {
+        const ios::fmtflags flags = out.flags();
+        const streamsize precision = out.precision();
+        auto printHeader = [&](const string& first) {
+            out << "[AI BMT]   " << left << setw(20) << "op type" << setw(first.empty() ? 0 : 32) << first << right
+                << setw(10) << "calls" << setw(12) << "total ms" << setw(12) << "mean us" << setw(10) << "share" << endl;
+        };
+        auto printRow = [&](const OperatorStats& stats, bool withNode) {
+            out << "[AI BMT]   " << left << setw(20) << stats.opType;
+            if (withNode)
+                out << setw(32) << (stats.node.size() > 31 ? stats.node.substr(0, 28) + "..." : stats.node);
+            out << right << setw(10) << stats.calls << setw(12) << stats.totalUs / 1000.0
+                << setw(12) << (stats.calls > 0 ? stats.totalUs / stats.calls : 0.0)
+                << setw(9) << (totalUs > 0 ? stats.totalUs / totalUs * 100.0 : 0.0) << "%" << endl;
+        };
+
+        out << "[AI BMT] Operator profile of " << modelName << " (" << fixed << setprecision(1) << totalUs / 1000.0
+            << " ms in " << nodes.size() << " node(s)):" << endl;
+        printHeader("");
+        for (const OperatorStats& opType : opTypes)
+            printRow(opType, false);
+        if (topNodes > 0 && !nodes.empty())
+        {
+            out << "[AI BMT] Top " << min(topNodes, nodes.size()) << " node(s) of " << modelName << ":" << endl;
+            printHeader("node");
+            for (size_t i = 0; i < nodes.size() && i < topNodes; ++i)
+                printRow(nodes[i], true);
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+#endif // AI_BMT_OP_PROFILE_H
@@ -0,0 +1,408 @@
+#ifndef AI_BMT_PERF_COUNTERS_H
+#define AI_BMT_PERF_COUNTERS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Counter values of one measured region. Events the CPU, kernel or container does not provide stay 0 and are marked unavailable.
+struct PerfCounterValues
+{
+    enum Event { TaskClock, Cycles, Instructions, LlcMisses, EventCount };
+
+    uint64_t values[EventCount] = {};
+
+    PerfCounterValues operator-(const PerfCounterValues& other) const
+    {
+        PerfCounterValues delta;
+        for (int i = 0; i < EventCount; ++i)
+            delta.values[i] = values[i] >= other.values[i] ? values[i] - other.values[i] : 0;
+        return delta;
+    }
+
+    PerfCounterValues& operator+=(const PerfCounterValues& other)
+    {
+        for (int i = 0; i < EventCount; ++i)
+            values[i] += other.values[i];
+        return *this;
+    }
+};
+
+// perf_event_open counters on a set of threads, one event group per thread, summed on read.
+// The group leader is the task-clock software event (CPU time), which most kernels allow even where hardware
+// events are missing (VMs, containers); cycles, instructions and LLC misses are added when available.
+class PerfCounterSet
+{
+private:
+#ifdef __linux__
+    struct ThreadGroup
+    {
+        pid_t tid = 0;
+        int leader = -1;
+        vector<int> members;
+    };
+
+    vector<ThreadGroup> groups;
+    vector<int> openedEvents; // PerfCounterValues::Event per group slot, in read order
+
+    static int openEvent(uint32_t type, uint64_t config, pid_t tid, int groupFd)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(SYS_perf_event_open, &attr, tid, -1, groupFd, 0);
+    }
+
+    static pair<uint32_t, uint64_t> eventType(int event)
+    {
+        switch (event)
+        {
+        case PerfCounterValues::TaskClock: return { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK };
+        case PerfCounterValues::Cycles: return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES };
+        case PerfCounterValues::Instructions: return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS };
+        default: return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES };
+        }
+    }
+
+    // The first thread decides which events are available; later threads open the same set.
+    bool openThread(pid_t tid, string& error)
+    {
+        ThreadGroup group;
+        group.tid = tid;
+        const bool firstThread = openedEvents.empty();
+        const vector<int> events = firstThread
+            ? vector<int>{ PerfCounterValues::TaskClock, PerfCounterValues::Cycles, PerfCounterValues::Instructions, PerfCounterValues::LlcMisses }
+            : openedEvents;
+        for (int event : events)
+        {
+            pair<uint32_t, uint64_t> type = eventType(event);
+            int fd = openEvent(type.first, type.second, tid, group.leader);
+            if (fd < 0)
+            {
+                if (group.leader < 0 || !firstThread)
+                {
+                    error = string("perf_event_open failed: ") + strerror(errno);
+                    closeGroup(group);
+                    return false;
+                }
+                continue; // Optional hardware event not available here
+            }
+            if (group.leader < 0)
+                group.leader = fd;
+            else
+                group.members.push_back(fd);
+            if (firstThread)
+                openedEvents.push_back(event);
+        }
+        groups.push_back(move(group));
+        return true;
+    }
+
+    static void closeGroup(ThreadGroup& group)
+    {
+        for (int fd : group.members)
+            close(fd);
+        if (group.leader >= 0)
+            close(group.leader);
+        group.members.clear();
+        group.leader = -1;
+    }
+#endif
+
+public:
+    PerfCounterSet() = default;
+    PerfCounterSet(const PerfCounterSet&) = delete;
+    PerfCounterSet& operator=(const PerfCounterSet&) = delete;
+
+    ~PerfCounterSet()
+    {
+#ifdef __linux__
+        for (ThreadGroup& group : groups)
+            closeGroup(group);
+#endif
+    }
+
+    // Counts the calling thread only.
+    bool openCallingThread(string& error)
+    {
+#ifdef __linux__
+        return openThread((pid_t)syscall(SYS_gettid), error);
+#else
+        error = "perf_event_open is only available on Linux";
+        return false;
+#endif
+    }
+
+    // Counts every thread that currently exists in the process (e.g., the ONNX Runtime intra-op pool created at
+    // Initialize). Threads started afterwards are not counted.
+    bool openProcess(string& error)
+    {
+#ifdef __linux__
+        DIR* tasks = opendir("/proc/self/task");
+        if (tasks == nullptr)
+        {
+            error = "cannot list /proc/self/task";
+            return false;
+        }
+        bool opened = false;
+        while (dirent* entry = readdir(tasks))
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            string threadError;
+            if (openThread((pid_t)atoi(entry->d_name), threadError))
+                opened = true;
+            else if (!opened && groups.empty())
+                error = threadError;
+        }
+        closedir(tasks);
+        return opened;
+#else
+        error = "perf_event_open is only available on Linux";
+        return false;
+#endif
+    }
+
+    // Stops counting a thread opened by openCallingThread/openProcess. Returns false if it was not counted.
+    bool closeThread(long tid)
+    {
+#ifdef __linux__
+        auto group = find_if(groups.begin(), groups.end(), [tid](const ThreadGroup& g) { return g.tid == (pid_t)tid; });
+        if (group == groups.end())
+            return false;
+        closeGroup(*group);
+        groups.erase(group);
+        return true;
+#else
+        (void)tid;
+        return false;
+#endif
+    }
+
+    bool isAvailable(int event) const
+    {
+#ifdef __linux__
+        return find(openedEvents.begin(), openedEvents.end(), event) != openedEvents.end();
+#else
+        (void)event;
+        return false;
+#endif
+    }
+
+    // Sum over all threads, scaled up when the kernel multiplexed the counters.
+    PerfCounterValues read() const
+    {
+        PerfCounterValues total;
+#ifdef __linux__
+        vector<uint64_t> buffer(3 + openedEvents.size());
+        for (const ThreadGroup& group : groups)
+        {
+            ssize_t bytes = ::read(group.leader, buffer.data(), buffer.size() * sizeof(uint64_t));
+            if (bytes < (ssize_t)(3 * sizeof(uint64_t)))
+                continue; // Thread exited
+            const uint64_t count = min<uint64_t>(buffer[0], openedEvents.size());
+            const uint64_t enabled = buffer[1];
+            const uint64_t running = buffer[2];
+            const double scale = (running > 0 && running < enabled) ? (double)enabled / running : 1.0;
+            for (uint64_t i = 0; i < count; ++i)
+                total.values[openedEvents[i]] += (uint64_t)(buffer[3 + i] * scale);
+        }
+#endif
+        return total;
+    }
+};
+
+// Process-wide hardware counter statistics per stage (e.g., "preprocess" per call, "runInference" per batch).
+// Disabled (and free) unless enable() succeeded.
+class HardwareCounterRecorder
+{
+private:
+    struct StageTotals
+    {
+        string name;
+        uint64_t calls = 0;
+        uint64_t queries = 0;
+        uint64_t wallNs = 0;
+        PerfCounterValues counters;
+    };
+
+    bool enabled = false;
+    unique_ptr<PerfCounterSet> processCounters;
+    mutable mutex processMutex; // excludeCallingThread() may close a group while another thread samples
+    mutable mutex statsMutex;
+    vector<StageTotals> stages;
+
+    HardwareCounterRecorder() = default;
+
+    PerfCounterSet* threadCounters()
+    {
+        thread_local unique_ptr<PerfCounterSet> counters;
+        thread_local bool attempted = false;
+        if (!attempted)
+        {
+            attempted = true;
+            string error;
+            counters = make_unique<PerfCounterSet>();
+            if (!counters->openCallingThread(error))
+                counters.reset();
+        }
+        return counters.get();
+    }
+
+public:
+    // A sample taken at the start of a region; pass it to recordProcess/recordThread at the end.
+    struct Sample
+    {
+        PerfCounterValues counters;
+        chrono::steady_clock::time_point time;
+    };
+
+    static HardwareCounterRecorder& instance()
+    {
+        static HardwareCounterRecorder recorder;
+        return recorder;
+    }
+
+    // Opens counters on all current threads of the process. Returns false (with a reason) if counters are unavailable,
+    // e.g., outside Linux, with kernel.perf_event_paranoid > 2, or in a container without perf_event access.
+    bool enable(string& reason)
+    {
+        processCounters = make_unique<PerfCounterSet>();
+        if (!processCounters->openProcess(reason))
+        {
+            processCounters.reset();
+            return false;
+        }
+        enabled = true;
+        if (!processCounters->isAvailable(PerfCounterValues::Cycles))
+            reason = "hardware events unavailable, reporting CPU time only";
+        return true;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    Sample sampleProcess() const
+    {
+        lock_guard<mutex> lock(processMutex);
+        return { processCounters->read(), chrono::steady_clock::now() };
+    }
+
+    // Leaves the calling thread out of the process-wide counters for good, e.g., a preprocessing thread that runs
+    // while runInference(..) is measured, so its work is not charged to inference. Threads started after enable()
+    // are not counted anyway; this also covers threads that already existed.
+    void excludeCallingThread()
+    {
+#ifdef __linux__
+        thread_local bool excluded = false;
+        if (!enabled || excluded)
+            return;
+        excluded = true;
+        lock_guard<mutex> lock(processMutex);
+        processCounters->closeThread(syscall(SYS_gettid));
+#endif
+    }
+
+    Sample sampleThread()
+    {
+        PerfCounterSet* counters = threadCounters();
+        return { counters ? counters->read() : PerfCounterValues(), chrono::steady_clock::now() };
+    }
+
+    void recordProcess(const string& stage, const Sample& start, size_t queries)
+    {
+        Sample end = sampleProcess();
+        record(stage, end.counters - start.counters, end.time - start.time, queries);
+    }
+
+    void recordThread(const string& stage, const Sample& start, size_t queries)
+    {
+        Sample end = sampleThread();
+        record(stage, end.counters - start.counters, end.time - start.time, queries);
+    }
+
+    void record(const string& stage, const PerfCounterValues& delta, chrono::steady_clock::duration wall, size_t queries)
+    {
+        lock_guard<mutex> lock(statsMutex);
+        auto totals = find_if(stages.begin(), stages.end(), [&](const StageTotals& s) { return s.name == stage; });
+        if (totals == stages.end())
+        {
+            stages.push_back(StageTotals());
+            stages.back().name = stage;
+            totals = stages.end() - 1;
+        }
+        ++totals->calls;
+        totals->queries += queries;
+        totals->wallNs += (uint64_t)chrono::duration_cast<chrono::nanoseconds>(wall).count();
+        totals->counters += delta;
+    }
+
+    void reset()
+    {
+        lock_guard<mutex> lock(statsMutex);
+        stages.clear();
+    }
+
+    // Per stage: CPU time, cycles, instructions, IPC and LLC misses per query, and an estimated memory bandwidth
+    // (LLC misses x 64-byte lines / wall time of the stage).
+    void print(ostream& out) const
+    {
+        if (!enabled)
+            return;
+        lock_guard<mutex> lock(statsMutex);
+        const bool hardware = processCounters->isAvailable(PerfCounterValues::Cycles);
+        const ios::fmtflags flags = out.flags();
+        const streamsize precision = out.precision();
+        out << "[AI BMT] Hardware counters (per query):" << endl;
+        out << "[AI BMT]   " << left << setw(16) << "stage" << right << setw(8) << "queries" << setw(12) << "cpu ms";
+        if (hardware)
+            out << setw(14) << "Mcycles" << setw(14) << "Minstr" << setw(8) << "IPC" << setw(14) << "LLC miss" << setw(12) << "est. GB/s";
+        out << endl << fixed;
+        for (const StageTotals& stage : stages)
+        {
+            const double queries = (double)max<uint64_t>(stage.queries, 1);
+            const PerfCounterValues& c = stage.counters;
+            out << "[AI BMT]   " << left << setw(16) << stage.name << right << setw(8) << stage.queries
+                << setprecision(3) << setw(12) << c.values[PerfCounterValues::TaskClock] / 1e6 / queries;
+            if (hardware)
+            {
+                const double cycles = (double)c.values[PerfCounterValues::Cycles];
+                const double instructions = (double)c.values[PerfCounterValues::Instructions];
+                out << setw(14) << cycles / 1e6 / queries << setw(14) << instructions / 1e6 / queries
+                    << setprecision(2) << setw(8) << (cycles > 0 ? instructions / cycles : 0.0);
+                if (processCounters->isAvailable(PerfCounterValues::LlcMisses))
+                {
+                    const double misses = (double)c.values[PerfCounterValues::LlcMisses];
+                    out << setprecision(0) << setw(14) << misses / queries
+                        << setprecision(2) << setw(12) << (stage.wallNs > 0 ? misses * 64.0 / stage.wallNs : 0.0);
+                }
+            }
+            out << endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+#endif // AI_BMT_PERF_COUNTERS_H
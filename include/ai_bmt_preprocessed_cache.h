@@ -0,0 +1,311 @@
+#ifndef AI_BMT_PREPROCESSED_CACHE_H
+#define AI_BMT_PREPROCESSED_CACHE_H
+
+#include "ai_bmt_file_utils.h"
+#include "ai_bmt_interface.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Binary cache of preprocessed queries, reused across benchmark runs through mmap.
+//
+// Layout (all offsets from the start of the file):
+//   [Header]                     magic, version, dtype, shape, preprocessing signature
+//   [SourceEntry x entryCount]   content hash and size of each source image, in dataset order
+//   [padding to 64 bytes]
+//   [entry 0][entry 1]...        one tensor per image, each starting on a 64-byte boundary
+//
+// Cached queries are handed out as the raw-pointer alternatives of VariantType (e.g., float*),
+// pointing straight into the mapping, so loading a cached dataset copies nothing. Queries that were TensorViews
+// come back as borrowed TensorViews with their recorded shape.
+class PreprocessedCache
+{
+public:
+    static constexpr size_t Alignment = 64;
+    // Raised whenever the layout or meaning of the header changes, so older caches are rebuilt instead of misread.
+    // 2: rank, flags and shape (formerly reserved) describe TensorView entries.
+    static constexpr uint32_t Version = 2;
+    static constexpr size_t MaxRank = 8;
+
+    // Element type of the cached tensors; matches the vector<T>/T* alternatives of VariantType.
+    enum DType : uint32_t
+    {
+        DTypeUInt8 = 1, DTypeUInt16, DTypeUInt32,
+        DTypeInt8, DTypeInt16, DTypeInt32,
+        DTypeFloat32, DTypeFloat16
+    };
+
+    enum Flags : uint32_t
+    {
+        FlagTensorView = 1 // Entries were TensorViews and are handed out with their shape
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t dtype;
+        uint64_t entryCount;
+        uint64_t elementCount;   // Elements per entry
+        uint64_t entryStride;    // Bytes between entries, a multiple of Alignment
+        uint64_t dataOffset;     // Offset of entry 0, a multiple of Alignment
+        uint32_t rank;
+        uint32_t flags;
+        int64_t shape[MaxRank];
+        char preprocessing[512]; // AI_BMT_Interface::getPreprocessingSignature()
+    };
+
+    struct SourceEntry
+    {
+        uint64_t contentHash;    // FNV-1a 64-bit hash of the source image file
+        uint64_t fileSize;
+    };
+
+private:
+    MappedFile file;
+    const Header* header = nullptr;
+
+    static constexpr char Magic[8] = { 'A', 'I', 'B', 'M', 'T', 'P', 'C', '\0' };
+
+    static size_t alignUp(size_t value) { return (value + Alignment - 1) / Alignment * Alignment; }
+
+    template <typename T> static uint32_t dtypeOf(const vector<T>&);
+    static uint32_t dtypeOf(const vector<uint8_t>&) { return DTypeUInt8; }
+    static uint32_t dtypeOf(const vector<uint16_t>&) { return DTypeUInt16; }
+    static uint32_t dtypeOf(const vector<uint32_t>&) { return DTypeUInt32; }
+    static uint32_t dtypeOf(const vector<int8_t>&) { return DTypeInt8; }
+    static uint32_t dtypeOf(const vector<int16_t>&) { return DTypeInt16; }
+    static uint32_t dtypeOf(const vector<int32_t>&) { return DTypeInt32; }
+    static uint32_t dtypeOf(const vector<float>&) { return DTypeFloat32; }
+
+    static size_t dtypeSize(uint32_t dtype)
+    {
+        switch (dtype)
+        {
+        case DTypeUInt8: case DTypeInt8: return 1;
+        case DTypeUInt16: case DTypeInt16: case DTypeFloat16: return 2;
+        case DTypeUInt32: case DTypeInt32: case DTypeFloat32: return 4;
+        default: throw runtime_error("Unknown cache dtype: " + to_string(dtype));
+        }
+    }
+
+    // Element type, element count and bytes of a vector<T> or TensorView query. Raw pointers cannot be cached (their size is unknown).
+    struct Payload
+    {
+        uint32_t dtype = 0;
+        size_t elementCount = 0;
+        const void* data = nullptr;
+        vector<int64_t> shape; // TensorView only
+    };
+
+    static Payload payloadOf(const VariantType& query)
+    {
+        return visit([](const auto& value) -> Payload {
+            return payloadOfValue(value);
+        }, query);
+    }
+
+    template <typename T>
+    static Payload payloadOfValue(const vector<T>& value)
+    {
+        return { dtypeOf(value), value.size(), value.data(), {} };
+    }
+
+#ifdef AI_BMT_CLI_BUILD
+    static Payload payloadOfValue(const TensorView& value)
+    {
+        if (!value.isContiguous())
+            throw runtime_error("Only contiguous TensorView preprocessed data can be cached");
+        if (value.shape.empty() || value.shape.size() > MaxRank)
+            throw runtime_error("TensorView rank must be 1 to " + to_string(MaxRank) + " to be cached");
+        static const uint32_t dtypes[] = { DTypeUInt8, DTypeUInt16, DTypeUInt32, DTypeInt8, DTypeInt16, DTypeInt32, DTypeFloat32, DTypeFloat16 };
+        return { dtypes[(size_t)value.dtype], value.elementCount(), value.data, value.shape };
+    }
+#endif
+
+    template <typename T>
+    static Payload payloadOfValue(const T&)
+    {
+        throw runtime_error("Only vector<T> preprocessed data can be cached");
+    }
+
+    static void copySignature(char (&target)[512], const string& signature)
+    {
+        if (signature.size() >= sizeof(target))
+            throw runtime_error("Preprocessing signature is too long for the cache header");
+        memset(target, 0, sizeof(target));
+        memcpy(target, signature.data(), signature.size());
+    }
+
+    const SourceEntry* sourceEntries() const
+    {
+        return (const SourceEntry*)(file.data() + sizeof(Header));
+    }
+
+public:
+    // Maps an existing cache. Returns false (with a reason) if it is missing, corrupt,
+    // built with other preprocessing parameters, or does not match the current dataset content.
+    // The file is never left mapped on failure, so build(..) can replace it (Windows refuses to rename over a mapped file).
+    // forEach(count, body) may run body in parallel; it is used to hash the source images.
+    bool open(const string& path, const vector<string>& imagePaths, const string& signature,
+        const function<void(size_t, const function<void(size_t)>&)>& forEach, string& reason)
+    {
+        header = nullptr;
+        file.close();
+        reason.clear();
+        if (!filesystem::exists(path))
+        {
+            reason = "no cache file";
+            return false;
+        }
+        file.openReadOnly(path);
+        if (file.size() < sizeof(Header))
+        {
+            reason = "truncated header";
+            file.close();
+            return false;
+        }
+        const Header* candidate = (const Header*)file.data();
+        char expectedSignature[512];
+        copySignature(expectedSignature, signature);
+        if (memcmp(candidate->magic, Magic, sizeof(Magic)) != 0 || candidate->version != Version)
+            reason = "unknown format";
+        else if (memcmp(candidate->preprocessing, expectedSignature, sizeof(expectedSignature)) != 0)
+            reason = "preprocessing parameters changed";
+        else if (candidate->entryCount != imagePaths.size())
+            reason = "dataset size changed";
+        else if (file.size() < candidate->dataOffset + candidate->entryCount * candidate->entryStride)
+            reason = "truncated data";
+        if (!reason.empty())
+        {
+            file.close();
+            return false;
+        }
+
+        header = candidate;
+        const SourceEntry* entries = sourceEntries();
+        vector<uint8_t> matches(imagePaths.size(), 0);
+        forEach(imagePaths.size(), [&](size_t i) {
+            uint64_t fileSize = 0;
+            uint64_t hash = hashFile(imagePaths[i], fileSize);
+            matches[i] = hash == entries[i].contentHash && fileSize == entries[i].fileSize;
+        });
+        for (size_t i = 0; i < matches.size(); ++i)
+        {
+            if (!matches[i])
+            {
+                reason = "source image changed: " + imagePaths[i];
+                header = nullptr;
+                file.close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Preprocesses every image with convert(i) and writes the cache to path (through a temporary file).
+    // All queries must have the same vector<T> type and size (or TensorView type and shape). forEach(count, body) may run body in parallel.
+    static void build(const string& path, const vector<string>& imagePaths, const string& signature,
+        const function<VariantType(size_t)>& convert,
+        const function<void(size_t, const function<void(size_t)>&)>& forEach)
+    {
+        if (imagePaths.empty())
+            throw runtime_error("Cannot build a cache for an empty dataset");
+
+        // The first query fixes the element type and size of every entry.
+        VariantType first = convert(0);
+        Payload firstPayload = payloadOf(first);
+        const size_t entryBytes = firstPayload.elementCount * dtypeSize(firstPayload.dtype);
+
+        Header newHeader;
+        memset(&newHeader, 0, sizeof(newHeader));
+        newHeader.version = Version;
+        newHeader.dtype = firstPayload.dtype;
+        newHeader.entryCount = imagePaths.size();
+        newHeader.elementCount = firstPayload.elementCount;
+        newHeader.entryStride = alignUp(entryBytes);
+        newHeader.dataOffset = alignUp(sizeof(Header) + imagePaths.size() * sizeof(SourceEntry));
+        if (firstPayload.shape.empty())
+        {
+            newHeader.rank = 1;
+            newHeader.shape[0] = (int64_t)firstPayload.elementCount;
+        }
+        else
+        {
+            newHeader.flags = FlagTensorView;
+            newHeader.rank = (uint32_t)firstPayload.shape.size();
+            copy(firstPayload.shape.begin(), firstPayload.shape.end(), newHeader.shape);
+        }
+        copySignature(newHeader.preprocessing, signature);
+
+        const string temporaryPath = path + ".tmp";
+        {
+            MappedFile output;
+            output.createReadWrite(temporaryPath, newHeader.dataOffset + newHeader.entryCount * newHeader.entryStride);
+            uint8_t* base = output.data();
+            SourceEntry* entries = (SourceEntry*)(base + sizeof(Header));
+
+            auto store = [&](size_t i, const VariantType& query) {
+                Payload payload = payloadOf(query);
+                if (payload.dtype != newHeader.dtype || payload.elementCount != newHeader.elementCount || payload.shape != firstPayload.shape)
+                    throw runtime_error("Preprocessed data of " + imagePaths[i] + " differs in type or size from the first image; cannot cache");
+                memcpy(base + newHeader.dataOffset + i * newHeader.entryStride, payload.data, entryBytes);
+                uint64_t fileSize = 0;
+                entries[i].contentHash = hashFile(imagePaths[i], fileSize);
+                entries[i].fileSize = fileSize;
+            };
+            store(0, first);
+            forEach(imagePaths.size() - 1, [&](size_t i) {
+                store(i + 1, convert(i + 1));
+            });
+
+            // The magic is written last so an interrupted build never looks valid.
+            memcpy(&newHeader.magic, Magic, sizeof(Magic));
+            memcpy(base, &newHeader, sizeof(newHeader));
+        }
+        filesystem::rename(temporaryPath, path);
+    }
+
+    size_t entryCount() const { return header ? (size_t)header->entryCount : 0; }
+    size_t entryBytes() const { return header ? (size_t)(header->elementCount * dtypeSize(header->dtype)) : 0; }
+
+    // Zero-copy query i as the raw-pointer alternative matching the cached dtype, or as a borrowed TensorView
+    // with the recorded shape. ONNX Runtime only reads inputs, so the const_cast onto the read-only mapping is safe.
+    VariantType entry(size_t i) const
+    {
+        uint8_t* data = const_cast<uint8_t*>(file.data() + header->dataOffset + i * header->entryStride);
+#ifdef AI_BMT_CLI_BUILD
+        if (header->flags & FlagTensorView)
+        {
+            static const TensorDataType types[] = { TensorDataType::UInt8, TensorDataType::UInt16, TensorDataType::UInt32,
+                TensorDataType::Int8, TensorDataType::Int16, TensorDataType::Int32, TensorDataType::Float32, TensorDataType::Float16 };
+            if (header->dtype < DTypeUInt8 || header->dtype > DTypeFloat16 || header->rank == 0 || header->rank > MaxRank)
+                throw runtime_error("Invalid cached tensor description");
+            TensorView view = TensorView::borrow(data, vector<int64_t>(header->shape, header->shape + header->rank));
+            view.dtype = types[header->dtype - DTypeUInt8];
+            return view;
+        }
+#endif
+        switch (header->dtype)
+        {
+        case DTypeUInt8: return (uint8_t*)data;
+        case DTypeUInt16: return (uint16_t*)data;
+        case DTypeUInt32: return (uint32_t*)data;
+        case DTypeInt8: return (int8_t*)data;
+        case DTypeInt16: return (int16_t*)data;
+        case DTypeInt32: return (int32_t*)data;
+        case DTypeFloat32: return (float*)data;
+        default: throw runtime_error("Unknown cache dtype: " + to_string(header->dtype));
+        }
+    }
+};
+
+#endif // AI_BMT_PREPROCESSED_CACHE_H
@@ -0,0 +1,271 @@
+#ifndef AI_BMT_RESULT_CHECK_H
+#define AI_BMT_RESULT_CHECK_H
+
+#include "ai_bmt_result_extras.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+using namespace std;
+
+// What the command-line driver does with the results of runInference(..) outside the measured region:
+// ResultOutputSummary reports how many bytes (and boxes) each query returned, and ResultCheck compares the compact
+// and encoded results of BMTResultExtras with the raw float32 results of the same queries (--check-results).
+
+inline size_t encodedBytes(const EncodedTensor& tensor)
+{
+    return tensor.float16Data.size() * sizeof(uint16_t) + tensor.int8Data.size() * sizeof(int8_t);
+}
+
+// Bytes of a query's result: the float vectors of BMTResult plus the extras stored for it.
+inline size_t resultPayloadBytes(const BMTResult& result, const BMTResultExtras* extras)
+{
+    size_t bytes = (result.classProbabilities.size() + result.objectDetectionResult.size() + result.segmentationResult.size()) * sizeof(float);
+    if (extras != nullptr)
+    {
+        bytes += extras->objectDetectionBoxes.size() * sizeof(Coco17DetectionResult) + extras->segmentationClassMap.size();
+        bytes += encodedBytes(extras->objectDetectionResultEncoded) + encodedBytes(extras->segmentationResultEncoded);
+    }
+    return bytes;
+}
+
+// Extras holding neither a class map nor an encoded tensor answer the query with boxes, possibly none.
+inline bool holdsBoxes(const BMTResultExtras& extras)
+{
+    return extras.segmentationClassMap.empty() && extras.objectDetectionResultEncoded.empty() && extras.segmentationResultEncoded.empty();
+}
+
+// Result size per query over a run, and boxes per query when the implementation returns boxes.
+class ResultOutputSummary
+{
+private:
+    size_t queryCount = 0;
+    size_t totalBytes = 0;
+    size_t boxQueryCount = 0; // Queries answered with objectDetectionBoxes
+    size_t totalBoxes = 0;
+    size_t minBoxes = 0;
+    size_t maxBoxes = 0;
+
+public:
+    void add(const BMTResult& result, const BMTResultExtras* extras)
+    {
+        ++queryCount;
+        totalBytes += resultPayloadBytes(result, extras);
+        if (extras == nullptr || !holdsBoxes(*extras))
+            return;
+        const size_t boxes = extras->objectDetectionBoxes.size();
+        minBoxes = boxQueryCount == 0 ? boxes : min(minBoxes, boxes);
+        maxBoxes = max(maxBoxes, boxes);
+        totalBoxes += boxes;
+        ++boxQueryCount;
+    }
+
+    size_t queries() const { return queryCount; }
+    double meanBytes() const { return queryCount == 0 ? 0 : (double)totalBytes / queryCount; }
+    size_t boxQueries() const { return boxQueryCount; }
+    double meanBoxes() const { return boxQueryCount == 0 ? 0 : (double)totalBoxes / boxQueryCount; }
+
+    void print(ostream& out) const
+    {
+        if (queryCount == 0)
+            return;
+        out << "[AI BMT] Result output: " << meanBytes() / 1024.0 << " KB per query" << endl;
+        if (boxQueryCount > 0)
+            out << "[AI BMT] Boxes per query: mean " << meanBoxes() << ", min " << minBoxes << ", max " << maxBoxes << endl;
+    }
+};
+
+namespace result_check_detail
+{
+    inline float intersectionOverUnion(const Coco17DetectionResult& a, const Coco17DetectionResult& b)
+    {
+        const float left = max(a.top_left_x, b.top_left_x);
+        const float top = max(a.top_left_y, b.top_left_y);
+        const float right = min(a.top_left_x + a.width, b.top_left_x + b.width);
+        const float bottom = min(a.top_left_y + a.height, b.top_left_y + b.height);
+        const float intersection = max(0.0f, right - left) * max(0.0f, bottom - top);
+        const float unionArea = a.width * a.height + b.width * b.height - intersection;
+        return unionArea > 0 ? intersection / unionArea : 0.0f;
+    }
+}
+
+// Compares compact and encoded results with the raw float32 results of the same queries. The two come from separate
+// runInference(..) calls, so the limits below allow for small run-to-run differences of the runtime.
+class ResultCheck
+{
+public:
+    // A box matches a reference box of the same class with at least this IoU and confidence within this distance.
+    static constexpr float MinBoxIoU = 0.9f;
+    static constexpr float MaxConfidenceError = 0.01f;
+    // Share of pixels whose class must equal the argmax of the raw logits; near-ties may flip between runs.
+    static constexpr double MinClassMapAgreement = 0.999;
+
+    struct BoxCounts
+    {
+        size_t queries = 0;
+        size_t expected = 0; // Boxes decoded from the raw results
+        size_t returned = 0; // Boxes in objectDetectionBoxes
+        size_t matched = 0;
+        float minIoU = 1.0f;
+
+        bool passed() const { return matched == expected && matched == returned; }
+    };
+
+    struct ClassMapCounts
+    {
+        size_t queries = 0;
+        size_t sizeMismatches = 0; // Class maps whose size does not divide the raw logits into planes
+        size_t pixels = 0;
+        size_t agreeing = 0;
+        size_t channels = 0;
+
+        double agreement() const { return pixels == 0 ? 1.0 : (double)agreeing / pixels; }
+        bool passed() const { return sizeMismatches == 0 && agreement() >= MinClassMapAgreement; }
+    };
+
+    struct EncodedCounts
+    {
+        size_t queries = 0;
+        size_t sizeMismatches = 0; // Encoded tensors with another element count than the raw output
+        size_t values = 0;
+        size_t outOfTolerance = 0;
+        double maxAbsError = 0;
+        size_t encodedBytes = 0;
+        size_t rawBytes = 0;
+        EncodedTensor::Encoding encoding = EncodedTensor::Encoding::Float16;
+
+        bool passed() const { return sizeMismatches == 0 && outOfTolerance == 0; }
+    };
+
+    // Largest accepted |decoded - raw|: twice the rounding error of the encoding, for run-to-run differences.
+    // float16 rounds to 11 significant bits (plus half the smallest subnormal); int8 to half a scale step.
+    static double encodingTolerance(const EncodedTensor& tensor, float raw)
+    {
+        if (tensor.encoding == EncodedTensor::Encoding::Float16)
+            return 2 * (fabs((double)raw) * 0x1p-11 + 0x1p-25);
+        return 2 * (0.5 * tensor.scale);
+    }
+
+private:
+    BoxCounts boxCounts;
+    ClassMapCounts classMapCounts;
+    EncodedCounts encodedCounts;
+
+public:
+    // Greedy one-to-one matching: each reference box takes the unmatched returned box of its class with the highest IoU.
+    void addBoxes(const vector<Coco17DetectionResult>& expected, const vector<Coco17DetectionResult>& returned)
+    {
+        ++boxCounts.queries;
+        boxCounts.expected += expected.size();
+        boxCounts.returned += returned.size();
+        vector<bool> taken(returned.size(), false);
+        for (const Coco17DetectionResult& reference : expected)
+        {
+            size_t best = returned.size();
+            float bestIoU = 0;
+            for (size_t i = 0; i < returned.size(); ++i)
+            {
+                if (taken[i] || returned[i].classIndex != reference.classIndex)
+                    continue;
+                const float iou = result_check_detail::intersectionOverUnion(reference, returned[i]);
+                if (iou > bestIoU)
+                {
+                    best = i;
+                    bestIoU = iou;
+                }
+            }
+            if (best == returned.size() || bestIoU < MinBoxIoU || fabs(returned[best].confidence - reference.confidence) > MaxConfidenceError)
+                continue;
+            taken[best] = true;
+            ++boxCounts.matched;
+            boxCounts.minIoU = min(boxCounts.minIoU, bestIoU);
+        }
+    }
+
+    // Compares a (Height, Width) class map with the argmax of the (Channel, Height, Width) logits, ties to the lower class.
+    void addClassMap(const vector<float>& logits, const vector<uint8_t>& classMap)
+    {
+        ++classMapCounts.queries;
+        if (classMap.empty() || logits.empty() || logits.size() % classMap.size() != 0)
+        {
+            ++classMapCounts.sizeMismatches;
+            return;
+        }
+        const size_t planeSize = classMap.size();
+        const size_t channels = logits.size() / planeSize;
+        classMapCounts.channels = channels;
+        classMapCounts.pixels += planeSize;
+        for (size_t p = 0; p < planeSize; ++p)
+        {
+            size_t best = 0;
+            for (size_t c = 1; c < channels; ++c)
+                if (logits[c * planeSize + p] > logits[best * planeSize + p])
+                    best = c;
+            classMapCounts.agreeing += classMap[p] == best;
+        }
+    }
+
+    // Compares an fp16/int8 output, read through DequantizedView, with the float32 output of the same query.
+    void addEncoded(const vector<float>& raw, const EncodedTensor& encoded)
+    {
+        ++encodedCounts.queries;
+        encodedCounts.encoding = encoded.encoding;
+        encodedCounts.encodedBytes += encodedBytes(encoded);
+        encodedCounts.rawBytes += raw.size() * sizeof(float);
+        const DequantizedView decoded(encoded);
+        if (decoded.size() != raw.size())
+        {
+            ++encodedCounts.sizeMismatches;
+            return;
+        }
+        encodedCounts.values += raw.size();
+        for (size_t i = 0; i < raw.size(); ++i)
+        {
+            const double error = fabs((double)decoded[i] - raw[i]);
+            if (!(error <= encodingTolerance(encoded, raw[i])))
+                ++encodedCounts.outOfTolerance;
+            if (error > encodedCounts.maxAbsError || isnan(error))
+                encodedCounts.maxAbsError = error;
+        }
+    }
+
+    const BoxCounts& boxes() const { return boxCounts; }
+    const ClassMapCounts& classMaps() const { return classMapCounts; }
+    const EncodedCounts& encodedOutputs() const { return encodedCounts; }
+
+    bool empty() const { return boxCounts.queries == 0 && classMapCounts.queries == 0 && encodedCounts.queries == 0; }
+    bool passed() const { return boxCounts.passed() && classMapCounts.passed() && encodedCounts.passed(); }
+
+    void print(ostream& out) const
+    {
+        if (boxCounts.queries > 0)
+        {
+            out << "[AI BMT] Result check, boxes: " << boxCounts.matched << " of " << boxCounts.expected << " decoded from the raw output matched, "
+                << boxCounts.returned << " returned";
+            if (boxCounts.matched > 0)
+                out << " (min IoU " << boxCounts.minIoU << ")";
+            out << (boxCounts.passed() ? "" : " - MISMATCH") << endl;
+        }
+        if (classMapCounts.queries > 0)
+        {
+            out << "[AI BMT] Result check, class maps: " << classMapCounts.agreement() * 100 << "% of " << classMapCounts.pixels
+                << " pixels agree with the argmax of the raw logits (" << classMapCounts.channels << " classes)";
+            if (classMapCounts.sizeMismatches > 0)
+                out << ", " << classMapCounts.sizeMismatches << " class map(s) do not fit the raw output";
+            out << (classMapCounts.passed() ? "" : " - MISMATCH") << endl;
+        }
+        if (encodedCounts.queries > 0)
+        {
+            out << "[AI BMT] Result check, " << (encodedCounts.encoding == EncodedTensor::Encoding::Float16 ? "float16" : "int8")
+                << " outputs: max abs error " << encodedCounts.maxAbsError << " against float32 over " << encodedCounts.values << " values, "
+                << encodedCounts.outOfTolerance << " out of tolerance, " << encodedCounts.encodedBytes / 1024.0 << " KB instead of "
+                << encodedCounts.rawBytes / 1024.0 << " KB";
+            if (encodedCounts.sizeMismatches > 0)
+                out << ", " << encodedCounts.sizeMismatches << " output(s) differ in size from the raw output";
+            out << (encodedCounts.passed() ? "" : " - MISMATCH") << endl;
+        }
+    }
+};
+
+#endif // AI_BMT_RESULT_CHECK_H
@@ -0,0 +1,138 @@
+#ifndef AI_BMT_RESULT_EXTRAS_H
+#define AI_BMT_RESULT_EXTRAS_H
+
+#include "ai_bmt_encoded_tensor.h"
+#include "ai_bmt_interface.h"
+#include "label_type.h"
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Compact and encoded results that do not fit in BMTResult.
+// BMTResult is shared with the prebuilt GUI library and keeps its layout, so implementations that reduce their
+// outputs on their side (e.g., detection_output=boxes, result_encoding=int8) keep these in a side table instead and expose them through
+// BMTResultExtrasProvider. Only the command-line driver (AI_BMT_CLI_BUILD) looks for them: it reports their size per
+// query and, with --check-results, compares them with raw results (ai_bmt_result_check.h). The GUI library reads
+// BMTResult alone.
+struct BMTResultExtras
+{
+    // Boxes after confidence filtering and NMS, in model-input pixels, instead of objectDetectionResult.
+    vector<Coco17DetectionResult> objectDetectionBoxes;
+
+    // Index of the highest-scoring class per pixel, 520(Height) x 520(Width), instead of segmentationResult.
+    vector<uint8_t> segmentationClassMap;
+
+    // fp16/int8 copies of objectDetectionResult and segmentationResult, filled instead of the float vectors
+    // (result_encoding=float16|int8). Read them through DequantizedView.
+    EncodedTensor objectDetectionResultEncoded;
+    EncodedTensor segmentationResultEncoded;
+};
+
+// Opt-in interface, implemented in addition to AI_BMT_Interface by implementations that return BMTResultExtras.
+class BMTResultExtrasProvider
+{
+public:
+    virtual ~BMTResultExtrasProvider() = default;
+
+    // Extras of a result returned by the last runInference(..), or nullptr if it has none.
+    // Valid until the vector holding the result is passed to releaseResults(..) or runInference(..) is called again.
+    virtual const BMTResultExtras* resultExtras(const BMTResult& result) const = 0;
+
+    // Boxes objectDetectionBoxes would hold for a query, decoded without SIMD from `raw`, the result of the same query
+    // with the compact and encoded modes off. False when the implementation does not return boxes.
+    virtual bool referenceBoxes(const BMTResult& /*raw*/, vector<Coco17DetectionResult>& /*boxes*/) const { return false; }
+};
+
+// Extras of a result, or nullptr if the implementation does not provide any.
+inline const BMTResultExtras* findResultExtras(AI_BMT_Interface& interface, const BMTResult& result)
+{
+    const BMTResultExtrasProvider* provider = dynamic_cast<const BMTResultExtrasProvider*>(&interface);
+    return provider ? provider->resultExtras(result) : nullptr;
+}
+
+// Throws when a setting asks for extras in a build whose caller cannot read them.
+inline void requireResultExtras(const string& setting)
+{
+#ifndef AI_BMT_CLI_BUILD
+    throw runtime_error(setting + " returns results outside BMTResult, which only the command-line driver reads (build with AI_BMT_HEADLESS)");
+#else
+    (void)setting;
+#endif
+}
+
+// Side table of an implementation, keyed by the address of the BMTResult the extras belong to.
+// BMTResult has no room for an id (its layout is shared with the GUI library), so the address identifies the result
+// while the caller keeps the vector returned by runInference(..) in place, as AI_BMT_Interface::releaseResults(..)
+// requires. Implementations call clear(..) at the start of runInference(..): extras of results that were copied,
+// moved or never released are dropped there instead of leaking or attaching to a new result at the same address.
+// Safe to fill from several threads.
+class BMTResultExtrasTable
+{
+private:
+    mutable mutex tableMutex;
+    unordered_map<const BMTResult*, BMTResultExtras> entries;
+
+public:
+    // Empty extras for result, to be filled in runInference(..). References stay valid while other entries are added.
+    BMTResultExtras& emplace(const BMTResult& result)
+    {
+        lock_guard<mutex> lock(tableMutex);
+        BMTResultExtras& extras = entries[&result];
+        extras = BMTResultExtras();
+        return extras;
+    }
+
+    const BMTResultExtras* find(const BMTResult& result) const
+    {
+        lock_guard<mutex> lock(tableMutex);
+        auto it = entries.find(&result);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    // Removes the extras of results and hands each to recycle(BMTResultExtras&), e.g., to return pooled buffers.
+    template <typename Recycle>
+    void release(const vector<BMTResult>& results, Recycle recycle)
+    {
+        lock_guard<mutex> lock(tableMutex);
+        for (const BMTResult& result : results)
+        {
+            auto it = entries.find(&result);
+            if (it == entries.end())
+                continue;
+            recycle(it->second);
+            entries.erase(it);
+        }
+    }
+
+    void release(const vector<BMTResult>& results)
+    {
+        release(results, [](BMTResultExtras&) {});
+    }
+
+    // Removes every entry, handing each to recycle(BMTResultExtras&) first.
+    template <typename Recycle>
+    void clear(Recycle recycle)
+    {
+        lock_guard<mutex> lock(tableMutex);
+        for (auto& entry : entries)
+            recycle(entry.second);
+        entries.clear();
+    }
+
+    void clear()
+    {
+        clear([](BMTResultExtras&) {});
+    }
+
+    size_t size() const
+    {
+        lock_guard<mutex> lock(tableMutex);
+        return entries.size();
+    }
+};
+
+#endif // AI_BMT_RESULT_EXTRAS_H
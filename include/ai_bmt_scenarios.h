@@ -0,0 +1,361 @@
+#ifndef AI_BMT_SCENARIOS_H
+#define AI_BMT_SCENARIOS_H
+
+#include "ai_bmt_interface.h"
+#include "ai_bmt_latency_histogram.h"
+#include "ai_bmt_perf_counters.h"
+#include "ai_bmt_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// MLPerf LoadGen-style test scenarios for any AI_BMT_Interface implementation.
+//   SingleStream  One sample per query; the next query is issued when the previous one completes.
+//                 Metric: 90th percentile latency.
+//   MultiStream   samplesPerQuery samples per query, issued every intervalMs. A query that cannot start
+//                 on time (the previous one overran the interval) starts late; latency counts from its
+//                 scheduled time. Metric: 99th percentile latency, valid if it fits in the interval.
+//   Server        Queries of one sample arrive as a Poisson process at targetQps. Samples that arrived while
+//                 runInference(..) was busy are batched (up to maxBatch) into the next call; latency counts
+//                 from arrival, so it includes queueing. Metric: 99th percentile latency, valid if it is
+//                 within latencyBoundMs (when set).
+//   Offline       All samples are available at once and run in batches of maxBatch. Metric: samples/s.
+enum class BenchmarkScenario
+{
+    SingleStream,
+    MultiStream,
+    Server,
+    Offline
+};
+
+inline const char* scenarioName(BenchmarkScenario scenario)
+{
+    switch (scenario)
+    {
+    case BenchmarkScenario::SingleStream: return "SingleStream";
+    case BenchmarkScenario::MultiStream: return "MultiStream";
+    case BenchmarkScenario::Server: return "Server";
+    default: return "Offline";
+    }
+}
+
+// Accepts "SingleStream", "single_stream", "singlestream", ... (case-insensitive, '_' and '-' ignored).
+inline bool parseScenario(const string& text, BenchmarkScenario& scenario)
+{
+    string name;
+    for (char c : text)
+    {
+        if (c != '_' && c != '-')
+            name += (char)tolower((unsigned char)c);
+    }
+    if (name == "singlestream")
+        scenario = BenchmarkScenario::SingleStream;
+    else if (name == "multistream")
+        scenario = BenchmarkScenario::MultiStream;
+    else if (name == "server")
+        scenario = BenchmarkScenario::Server;
+    else if (name == "offline")
+        scenario = BenchmarkScenario::Offline;
+    else
+        return false;
+    return true;
+}
+
+struct ScenarioSettings
+{
+    BenchmarkScenario scenario = BenchmarkScenario::SingleStream;
+    size_t minQueryCount = 0;       // 0 = one query per sample in the dataset (Offline: minimum samples, 0 = one pass)
+    double minDurationS = 0;        // The run continues until both minimums are met
+    size_t samplesPerQuery = 8;     // MultiStream
+    double intervalMs = 50;         // MultiStream
+    double targetQps = 10;          // Server
+    double latencyBoundMs = 0;      // Server (0 = no bound)
+    size_t maxBatch = 1;            // Server and Offline: samples per runInference(..) call
+    uint64_t seed = 0;              // Sample order and Server arrivals
+};
+
+// Result of one scenario run, printed in the same format for every scenario.
+struct ScenarioReport
+{
+    BenchmarkScenario scenario = BenchmarkScenario::SingleStream;
+    size_t queryCount = 0;
+    size_t sampleCount = 0;
+    size_t inferenceCalls = 0;
+    size_t lateQueries = 0;         // MultiStream: queries that could not start on schedule
+    double durationS = 0;
+    LatencyHistogram latency;       // One value per query
+    string metricName;
+    double metricValue = 0;
+    string metricUnit;
+    bool valid = true;
+    string invalidReason;
+
+    // Percentile of the query latencies, p in [0, 100].
+    double latencyPercentileMs(double p) const
+    {
+        return latency.percentileNs(p) / 1e6;
+    }
+
+    void print(ostream& out) const
+    {
+        out << "[AI BMT] ===== Scenario: " << scenarioName(scenario) << " =====" << endl;
+        out << "[AI BMT] Queries: " << queryCount << ", samples: " << sampleCount << ", runInference calls: " << inferenceCalls
+            << ", duration: " << durationS << " s" << endl;
+        out << "[AI BMT] Throughput: " << sampleCount / durationS << " samples/s, " << queryCount / durationS << " queries/s" << endl;
+        if (latency.count() > 0)
+        {
+            out << "[AI BMT] Query latency (ms): min " << latency.minNs() / 1e6
+                << ", mean " << latency.meanNs() / 1e6
+                << ", p50 " << latencyPercentileMs(50)
+                << ", p90 " << latencyPercentileMs(90)
+                << ", p95 " << latencyPercentileMs(95)
+                << ", p99 " << latencyPercentileMs(99)
+                << ", p99.9 " << latencyPercentileMs(99.9)
+                << ", max " << latency.maxNs() / 1e6 << endl;
+        }
+        if (scenario == BenchmarkScenario::MultiStream)
+            out << "[AI BMT] Late queries: " << lateQueries << endl;
+        out << "[AI BMT] Result: " << metricName << " = " << metricValue << " " << metricUnit
+            << (valid ? " (VALID)" : " (INVALID: " + invalidReason + ")") << endl;
+    }
+};
+
+// Issues queries built from a preprocessed dataset according to a scenario.
+// Samples are moved into each query and moved back after runInference(..), so building queries copies nothing;
+// a query therefore never holds more samples than the dataset contains.
+class ScenarioRunner
+{
+private:
+    using Clock = chrono::steady_clock;
+
+    AI_BMT_Interface& interface;
+    vector<VariantType>& dataset;
+    vector<size_t> sampleOrder;
+    size_t nextSample = 0;
+    LatencyHistogram& queryLatency = LatencyRecorder::instance().histogram("query");
+    LatencyHistogram& inferenceLatency = LatencyRecorder::instance().histogram("runInference");
+
+    static double elapsedMs(Clock::time_point start, Clock::time_point end)
+    {
+        return chrono::duration<double, milli>(end - start).count();
+    }
+
+    static string formatNumber(double value)
+    {
+        ostringstream text;
+        text << value;
+        return text.str();
+    }
+
+    // Runs one runInference(..) call on the next `count` samples and returns its completion time.
+    Clock::time_point issue(size_t count, ScenarioReport& report)
+    {
+        vector<size_t> indices(count);
+        vector<VariantType> batch(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            indices[i] = sampleOrder[nextSample];
+            nextSample = (nextSample + 1) % sampleOrder.size();
+            batch[i] = move(dataset[indices[i]]);
+        }
+
+        HardwareCounterRecorder& counters = HardwareCounterRecorder::instance();
+        HardwareCounterRecorder::Sample counterStart;
+        if (counters.isEnabled())
+            counterStart = counters.sampleProcess();
+        Clock::time_point start = Clock::now();
+        const int64_t traceStartNs = traceClockNs();
+        vector<BMTResult> results = interface.runInference(batch);
+        Clock::time_point end = Clock::now();
+        if (counters.isEnabled())
+            counters.recordProcess("runInference", counterStart, count);
+        if (TraceRecorder::instance().isEnabled())
+            TraceRecorder::instance().recordSpan("harness", "runInference", traceStartNs, traceClockNs(), to_string(count) + " samples");
+        inferenceLatency.record(end - start);
+
+        interface.releaseResults(results);
+        for (size_t i = 0; i < count; ++i)
+            dataset[indices[i]] = move(batch[i]);
+        ++report.inferenceCalls;
+        report.sampleCount += count;
+        return end;
+    }
+
+    // Records one query's latency in the report and in the process-wide "query" histogram.
+    void recordQuery(Clock::time_point start, Clock::time_point end, ScenarioReport& report)
+    {
+        report.latency.record(end - start);
+        queryLatency.record(end - start);
+        ++report.queryCount;
+    }
+
+    bool minimumsMet(const ScenarioSettings& settings, const ScenarioReport& report, Clock::time_point start) const
+    {
+        return report.queryCount >= settings.minQueryCount && elapsedMs(start, Clock::now()) >= settings.minDurationS * 1000.0;
+    }
+
+    void runSingleStream(const ScenarioSettings& settings, ScenarioReport& report)
+    {
+        Clock::time_point start = Clock::now();
+        while (!minimumsMet(settings, report, start))
+        {
+            Clock::time_point issued = Clock::now();
+            Clock::time_point end = issue(1, report);
+            recordQuery(issued, end, report);
+        }
+        report.durationS = elapsedMs(start, Clock::now()) / 1000.0;
+        report.metricName = "90th percentile latency";
+        report.metricValue = report.latencyPercentileMs(90);
+        report.metricUnit = "ms";
+    }
+
+    void runMultiStream(const ScenarioSettings& settings, ScenarioReport& report)
+    {
+        const size_t samplesPerQuery = min(max<size_t>(1, settings.samplesPerQuery), dataset.size());
+        const auto interval = chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(settings.intervalMs));
+        Clock::time_point start = Clock::now();
+        Clock::time_point scheduled = start;
+        while (!minimumsMet(settings, report, start))
+        {
+            Clock::time_point now = Clock::now();
+            if (now < scheduled)
+                this_thread::sleep_until(scheduled);
+            else if (now - scheduled > chrono::microseconds(100))
+                ++report.lateQueries;
+            Clock::time_point end = issue(samplesPerQuery, report);
+            recordQuery(scheduled, end, report);
+            scheduled += interval;
+        }
+        report.durationS = elapsedMs(start, Clock::now()) / 1000.0;
+        report.metricName = "99th percentile latency";
+        report.metricValue = report.latencyPercentileMs(99);
+        report.metricUnit = "ms";
+        if (report.metricValue > settings.intervalMs)
+        {
+            report.valid = false;
+            report.invalidReason = "exceeds the " + formatNumber(settings.intervalMs) + " ms interval";
+        }
+    }
+
+    // Trace spans from each query's arrival until it is issued.
+    static void recordQueueSpans(const deque<Clock::time_point>& waiting, size_t count)
+    {
+        TraceRecorder& trace = TraceRecorder::instance();
+        if (!trace.isEnabled())
+            return;
+        const Clock::time_point now = Clock::now();
+        const int64_t nowNs = traceClockNs();
+        for (size_t i = 0; i < count; ++i)
+            trace.recordSpan("harness", "queue", nowNs - chrono::duration_cast<chrono::nanoseconds>(now - waiting[i]).count(), nowNs);
+    }
+
+    void runServer(const ScenarioSettings& settings, ScenarioReport& report)
+    {
+        if (!(settings.targetQps > 0) || !isfinite(settings.targetQps))
+            throw invalid_argument("Server scenario needs a positive target QPS");
+        const size_t maxBatch = min(max<size_t>(1, settings.maxBatch), dataset.size());
+        mt19937_64 generator(settings.seed);
+        exponential_distribution<double> interArrivalS(settings.targetQps);
+
+        Clock::time_point start = Clock::now();
+        Clock::time_point nextArrival = start;
+        deque<Clock::time_point> waiting; // Arrival times of queries not yet issued
+        size_t arrivedCount = 0;
+        bool arriving = true;
+        while (true)
+        {
+            // Once the minimums are met no new queries arrive; the queue is drained.
+            if (arriving && arrivedCount >= settings.minQueryCount && elapsedMs(start, Clock::now()) >= settings.minDurationS * 1000.0)
+                arriving = false;
+            if (waiting.empty())
+            {
+                if (!arriving)
+                    break;
+                this_thread::sleep_until(nextArrival);
+            }
+
+            Clock::time_point now = Clock::now();
+            while (arriving && nextArrival <= now)
+            {
+                waiting.push_back(nextArrival);
+                ++arrivedCount;
+                nextArrival += chrono::duration_cast<Clock::duration>(chrono::duration<double>(interArrivalS(generator)));
+            }
+
+            size_t count = min(maxBatch, waiting.size());
+            recordQueueSpans(waiting, count);
+            Clock::time_point end = issue(count, report);
+            for (size_t i = 0; i < count; ++i)
+            {
+                recordQuery(waiting.front(), end, report);
+                waiting.pop_front();
+            }
+        }
+        report.durationS = elapsedMs(start, Clock::now()) / 1000.0;
+        report.metricName = "99th percentile latency at " + formatNumber(settings.targetQps) + " target QPS";
+        report.metricValue = report.latencyPercentileMs(99);
+        report.metricUnit = "ms";
+        if (settings.latencyBoundMs > 0 && report.metricValue > settings.latencyBoundMs)
+        {
+            report.valid = false;
+            report.invalidReason = "exceeds the " + formatNumber(settings.latencyBoundMs) + " ms latency bound";
+        }
+    }
+
+    void runOffline(const ScenarioSettings& settings, ScenarioReport& report)
+    {
+        // A single query holding every sample, split into runInference(..) calls of maxBatch samples.
+        const size_t sampleCount = max(settings.minQueryCount, dataset.size());
+        const size_t maxBatch = settings.maxBatch == 0 ? dataset.size() : min(settings.maxBatch, dataset.size());
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start;
+        while (report.sampleCount < sampleCount || elapsedMs(start, end) < settings.minDurationS * 1000.0)
+        {
+            size_t remaining = report.sampleCount < sampleCount ? sampleCount - report.sampleCount : maxBatch;
+            end = issue(min(maxBatch, remaining), report);
+        }
+        recordQuery(start, end, report);
+        report.durationS = elapsedMs(start, end) / 1000.0;
+        report.metricName = "Throughput";
+        report.metricValue = report.sampleCount / report.durationS;
+        report.metricUnit = "samples/s";
+    }
+
+public:
+    ScenarioRunner(AI_BMT_Interface& interface, vector<VariantType>& dataset, uint64_t seed = 0)
+        : interface(interface), dataset(dataset), sampleOrder(dataset.size())
+    {
+        if (dataset.empty())
+            throw runtime_error("Scenario runs need at least one preprocessed sample");
+        iota(sampleOrder.begin(), sampleOrder.end(), 0);
+        mt19937_64 generator(seed);
+        shuffle(sampleOrder.begin(), sampleOrder.end(), generator);
+    }
+
+    ScenarioReport run(ScenarioSettings settings)
+    {
+        if (settings.minQueryCount == 0)
+            settings.minQueryCount = dataset.size();
+        ScenarioReport report;
+        report.scenario = settings.scenario;
+        switch (settings.scenario)
+        {
+        case BenchmarkScenario::SingleStream: runSingleStream(settings, report); break;
+        case BenchmarkScenario::MultiStream: runMultiStream(settings, report); break;
+        case BenchmarkScenario::Server: runServer(settings, report); break;
+        case BenchmarkScenario::Offline: runOffline(settings, report); break;
+        }
+        return report;
+    }
+};
+
+#endif // AI_BMT_SCENARIOS_H
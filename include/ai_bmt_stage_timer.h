@@ -0,0 +1,127 @@
+#ifndef AI_BMT_STAGE_TIMER_H
+#define AI_BMT_STAGE_TIMER_H
+
+#include "ai_bmt_latency_histogram.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Scoped stage timers for a per-stage breakdown of runInference(..).
+// AI_BMT_SCOPED_STAGE("stage.<name>") records the time until the end of the enclosing scope into the
+// LatencyRecorder histogram of that name while the timers are enabled: by the command-line driver's --stages 1, or
+// from the start when built with AI_BMT_STAGE_TIMERS (e.g., for the GUI build). A disabled stage costs one relaxed load.
+//
+//   virtual vector<BMTResult> runInference(const vector<VariantType>& data) override
+//   {
+//       AI_BMT_SCOPED_STAGE("stage.runInference");
+//       ...
+//   }
+inline atomic<bool>& stageTimersFlag()
+{
+#ifdef AI_BMT_STAGE_TIMERS
+    static atomic<bool> enabled{ true };
+#else
+    static atomic<bool> enabled{ false };
+#endif
+    return enabled;
+}
+
+inline bool stageTimersEnabled() { return stageTimersFlag().load(memory_order_relaxed); }
+
+inline void enableStageTimers(bool enabled) { stageTimersFlag().store(enabled, memory_order_relaxed); }
+
+class ScopedStageTimer
+{
+private:
+    LatencyHistogram* histogram; // nullptr while the timers are disabled
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedStageTimer(LatencyHistogram& stageHistogram)
+        : histogram(stageTimersEnabled() ? &stageHistogram : nullptr)
+    {
+        if (histogram != nullptr)
+            start = chrono::steady_clock::now();
+    }
+
+    ~ScopedStageTimer()
+    {
+        if (histogram != nullptr)
+            histogram->record(chrono::steady_clock::now() - start);
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
+
+#define AI_BMT_STAGE_CONCAT_INNER(a, b) a##b
+#define AI_BMT_STAGE_CONCAT(a, b) AI_BMT_STAGE_CONCAT_INNER(a, b)
+// The histogram is looked up once per call site; afterwards an enabled stage costs two clock reads and a few relaxed atomics.
+#define AI_BMT_SCOPED_STAGE(name) \
+    static LatencyHistogram& AI_BMT_STAGE_CONCAT(stageHistogram_, __LINE__) = LatencyRecorder::instance().histogram(name); \
+    ScopedStageTimer AI_BMT_STAGE_CONCAT(stageTimer_, __LINE__)(AI_BMT_STAGE_CONCAT(stageHistogram_, __LINE__))
+
+// Prints the total time of every "stage.*" histogram and its share of "stage.runInference".
+// Stages are expected not to nest, except within stage.runInference; the remainder is shown as unattributed.
+// Totals are summed over every thread that recorded the stage: when an implementation runs work concurrently
+// inside one runInference(..) call (e.g., session_count > 1), the stages can add up to more than runInference.
+// Prints nothing when the stage timers were not enabled.
+inline void printStageBreakdown(ostream& out)
+{
+    const string prefix = "stage.";
+    const string parent = prefix + "runInference";
+    vector<pair<string, const LatencyHistogram*>> stages;
+    const LatencyHistogram* parentHistogram = nullptr;
+    for (const auto& entry : LatencyRecorder::instance().snapshot())
+    {
+        if (entry.first.compare(0, prefix.size(), prefix) != 0 || entry.second->count() == 0)
+            continue;
+        if (entry.first == parent)
+            parentHistogram = entry.second;
+        else
+            stages.push_back(entry);
+    }
+    if (parentHistogram == nullptr && stages.empty())
+        return;
+
+    const double parentMs = parentHistogram ? parentHistogram->sumNs() / 1e6 : 0;
+    const ios::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+    auto printRow = [&](const string& name, uint64_t calls, double totalMs) {
+        out << "[AI BMT]   " << left << setw(24) << name << right;
+        if (calls > 0)
+            out << setw(10) << calls << setw(14) << totalMs << setw(12) << totalMs * 1000.0 / calls;
+        else
+            out << setw(10) << "" << setw(14) << totalMs << setw(12) << "";
+        if (parentMs > 0)
+            out << setw(9) << totalMs / parentMs * 100.0 << "%";
+        out << endl;
+    };
+
+    out << "[AI BMT] Stage breakdown (totals summed over all threads):" << endl;
+    out << "[AI BMT]   " << left << setw(24) << "stage" << right << setw(10) << "calls" << setw(14) << "total ms" << setw(12) << "mean us";
+    if (parentMs > 0)
+        out << setw(10) << "share";
+    out << endl << fixed << setprecision(1);
+    if (parentHistogram)
+        printRow(parent.substr(prefix.size()), parentHistogram->count(), parentMs);
+    double attributedMs = 0;
+    for (const auto& stage : stages)
+    {
+        const double totalMs = stage.second->sumNs() / 1e6;
+        attributedMs += totalMs;
+        printRow("  " + stage.first.substr(prefix.size()), stage.second->count(), totalMs);
+    }
+    if (parentMs > 0)
+        printRow("  (unattributed)", 0, max(0.0, parentMs - attributedMs));
+    if (attributedMs > parentMs && parentMs > 0)
+        out << "[AI BMT]   Stage totals are summed over concurrent threads and exceed runInference." << endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+#endif // AI_BMT_STAGE_TIMER_H
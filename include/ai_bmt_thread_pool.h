@@ -0,0 +1,180 @@
+#ifndef AI_BMT_THREAD_POOL_H
+#define AI_BMT_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Work-stealing thread pool used by the command-line driver to fan preprocessing out across cores.
+// Each worker owns a deque: it pops its own tasks from the back and, when empty,
+// steals from the front of the other workers' deques, so uneven per-image decode costs even out.
+class WorkStealingThreadPool
+{
+private:
+    struct WorkQueue
+    {
+        mutex queueMutex;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<thread> workers;
+
+    mutex stateMutex;
+    condition_variable workAvailable;
+    condition_variable allDone;
+    atomic<size_t> queuedTasks{ 0 }; // Raised before a task is pushed, so a worker popping it never takes the count below zero
+    size_t unfinishedTasks = 0;
+    size_t nextQueue = 0;
+    bool stopping = false;
+    exception_ptr firstError;
+
+    bool popLocal(size_t index, function<void()>& task)
+    {
+        WorkQueue& queue = *queues[index];
+        lock_guard<mutex> lock(queue.queueMutex);
+        if (queue.tasks.empty())
+            return false;
+        task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, function<void()>& task)
+    {
+        for (size_t offset = 1; offset < queues.size(); ++offset)
+        {
+            WorkQueue& queue = *queues[(thief + offset) % queues.size()];
+            lock_guard<mutex> lock(queue.queueMutex);
+            if (!queue.tasks.empty())
+            {
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index)
+    {
+        while (true)
+        {
+            function<void()> task;
+            if (popLocal(index, task) || steal(index, task))
+            {
+                queuedTasks.fetch_sub(1);
+                try {
+                    task();
+                }
+                catch (...) {
+                    lock_guard<mutex> lock(stateMutex);
+                    if (!firstError)
+                        firstError = current_exception();
+                }
+
+                lock_guard<mutex> lock(stateMutex);
+                if (--unfinishedTasks == 0)
+                    allDone.notify_all();
+                continue;
+            }
+
+            unique_lock<mutex> lock(stateMutex);
+            workAvailable.wait(lock, [this] { return stopping || queuedTasks.load() > 0; });
+            if (stopping && queuedTasks.load() == 0)
+                return;
+        }
+    }
+
+public:
+    // threadCount = 0 uses one worker per hardware thread.
+    explicit WorkStealingThreadPool(size_t threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = max<size_t>(1, thread::hardware_concurrency());
+        for (size_t i = 0; i < threadCount; ++i)
+            queues.push_back(make_unique<WorkQueue>());
+        for (size_t i = 0; i < threadCount; ++i)
+            workers.emplace_back(&WorkStealingThreadPool::workerLoop, this, i);
+    }
+
+    ~WorkStealingThreadPool()
+    {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (thread& worker : workers)
+            worker.join();
+    }
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    size_t threadCount() const { return workers.size(); }
+
+    // Queues a task on the workers in round-robin order.
+    void submit(function<void()> task)
+    {
+        size_t index;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            ++unfinishedTasks;
+            queuedTasks.fetch_add(1);
+            index = nextQueue++ % queues.size();
+        }
+        {
+            lock_guard<mutex> lock(queues[index]->queueMutex);
+            queues[index]->tasks.push_back(move(task));
+        }
+        workAvailable.notify_one();
+    }
+
+    // Runs body(i) for i in [0, count). Each worker initially receives one contiguous block
+    // (keeping neighbouring items on the same core); idle workers steal the rest.
+    void parallelFor(size_t count, const function<void(size_t)>& body)
+    {
+        const size_t blocks = queues.size();
+        {
+            lock_guard<mutex> lock(stateMutex);
+            unfinishedTasks += count;
+            queuedTasks.fetch_add(count);
+        }
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            const size_t begin = count * block / blocks;
+            const size_t end = count * (block + 1) / blocks;
+            lock_guard<mutex> lock(queues[block]->queueMutex);
+            // Pushed in reverse so the owner (popping from the back) walks its block in order
+            // while thieves take the far end from the front.
+            for (size_t i = end; i > begin; --i)
+                queues[block]->tasks.push_back([&body, i] { body(i - 1); });
+        }
+        workAvailable.notify_all();
+        wait();
+    }
+
+    // Blocks until every submitted task has finished; rethrows the first exception thrown by a task.
+    void wait()
+    {
+        unique_lock<mutex> lock(stateMutex);
+        allDone.wait(lock, [this] { return unfinishedTasks == 0; });
+        if (firstError)
+        {
+            exception_ptr error = firstError;
+            firstError = nullptr;
+            rethrow_exception(error);
+        }
+    }
+};
+
+#endif // AI_BMT_THREAD_POOL_H
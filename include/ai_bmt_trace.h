@@ -0,0 +1,253 @@
+#ifndef AI_BMT_TRACE_H
+#define AI_BMT_TRACE_H
+
+#include "ai_bmt_json.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Timestamps shared with ONNX Runtime's profiler: nanoseconds since the epoch of high_resolution_clock,
+// the clock behind Session::GetProfilingStartTimeNs(). Harness spans and ORT events therefore line up in one trace.
+inline int64_t traceClockNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+// ONNX Runtime profile file written by Session::EndProfilingAllocated, with the session's profiling start time.
+struct OrtProfileFile
+{
+    string modelName;
+    string path;
+    int64_t startNs = 0;
+};
+
+// Process-wide trace of harness spans (preprocessing, queueing, runInference, ...) plus the ONNX Runtime
+// profiles of every session that enabled profiling. writeChromeTrace(..) merges both into one Chrome trace
+// JSON (chrome://tracing, https://ui.perfetto.dev) on the shared clock.
+class TraceRecorder
+{
+private:
+    struct Span
+    {
+        string name;
+        string category;
+        string detail;
+        int64_t startNs;
+        int64_t durationNs;
+        uint32_t threadId;
+    };
+
+    struct ProfileSource
+    {
+        const void* owner;
+        function<OrtProfileFile()> finish;
+    };
+
+    atomic<bool> enabled{ false };
+    int64_t originNs = 0;
+    mutable mutex traceMutex;
+    vector<Span> spans;
+    vector<ProfileSource> profileSources;
+    vector<OrtProfileFile> finishedProfiles;
+
+    TraceRecorder() = default;
+
+    static JsonValue metadataEvent(int pid, const string& processName)
+    {
+        JsonValue event = JsonValue::makeObject();
+        event.set("name", JsonValue::makeString("process_name"));
+        event.set("ph", JsonValue::makeString("M"));
+        event.set("pid", JsonValue::makeNumber(pid));
+        JsonValue args = JsonValue::makeObject();
+        args.set("name", JsonValue::makeString(processName));
+        event.set("args", move(args));
+        return event;
+    }
+
+public:
+    static TraceRecorder& instance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // Starts recording harness spans; trace timestamps are relative to this moment.
+    void enable()
+    {
+        originNs = traceClockNs();
+        enabled.store(true);
+    }
+
+    bool isEnabled() const { return enabled.load(memory_order_relaxed); }
+
+    // Small, stable id of the calling thread for the trace's "tid" field.
+    static uint32_t currentThreadId()
+    {
+        static atomic<uint32_t> nextId{ 1 };
+        thread_local uint32_t id = nextId.fetch_add(1);
+        return id;
+    }
+
+    void recordSpan(const string& category, const string& name, int64_t startNs, int64_t endNs, const string& detail = "")
+    {
+        if (!isEnabled())
+            return;
+        Span span{ name, category, detail, startNs, endNs - startNs, currentThreadId() };
+        lock_guard<mutex> lock(traceMutex);
+        spans.push_back(move(span));
+    }
+
+    // A session with profiling enabled registers how to end its profile. The profile is finished when the owner
+    // calls finishProfileSource (e.g., on destruction or re-initialization) or at the end of the run.
+    void registerProfileSource(const void* owner, function<OrtProfileFile()> finish)
+    {
+        finishProfileSource(owner);
+        lock_guard<mutex> lock(traceMutex);
+        profileSources.push_back({ owner, move(finish) });
+    }
+
+    void finishProfileSource(const void* owner)
+    {
+        function<OrtProfileFile()> finish;
+        {
+            lock_guard<mutex> lock(traceMutex);
+            auto source = find_if(profileSources.begin(), profileSources.end(), [&](const ProfileSource& s) { return s.owner == owner; });
+            if (source == profileSources.end())
+                return;
+            finish = move(source->finish);
+            profileSources.erase(source);
+        }
+        OrtProfileFile profile = finish();
+        lock_guard<mutex> lock(traceMutex);
+        finishedProfiles.push_back(move(profile));
+    }
+
+    // Ends every profile still open and returns all finished profiles of this process.
+    vector<OrtProfileFile> finishProfiles()
+    {
+        while (true)
+        {
+            const void* owner;
+            {
+                lock_guard<mutex> lock(traceMutex);
+                if (profileSources.empty())
+                    return finishedProfiles;
+                owner = profileSources.front().owner;
+            }
+            finishProfileSource(owner);
+        }
+    }
+
+    // Writes harness spans (pid 1) and each ORT profile (pid 2, 3, ...) as one Chrome trace.
+    void writeChromeTrace(const string& path)
+    {
+        vector<OrtProfileFile> profiles = finishProfiles();
+        ofstream file(path, ios::binary);
+        if (!file)
+            throw runtime_error("Failed to write " + path);
+
+        lock_guard<mutex> lock(traceMutex);
+        int64_t origin = originNs;
+        if (origin == 0)
+        {
+            origin = INT64_MAX;
+            for (const OrtProfileFile& profile : profiles)
+                origin = min(origin, profile.startNs);
+        }
+
+        bool first = true;
+        auto writeEvent = [&](const JsonValue& event) {
+            file << (first ? "\n" : ",\n");
+            JsonWriter::write(file, event);
+            first = false;
+        };
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        writeEvent(metadataEvent(1, "AI BMT harness"));
+        for (const Span& span : spans)
+        {
+            JsonValue event = JsonValue::makeObject();
+            event.set("name", JsonValue::makeString(span.name));
+            event.set("cat", JsonValue::makeString(span.category));
+            event.set("ph", JsonValue::makeString("X"));
+            event.set("ts", JsonValue::makeNumber((span.startNs - origin) / 1000.0));
+            event.set("dur", JsonValue::makeNumber(span.durationNs / 1000.0));
+            event.set("pid", JsonValue::makeNumber(1));
+            event.set("tid", JsonValue::makeNumber(span.threadId));
+            if (!span.detail.empty())
+            {
+                JsonValue args = JsonValue::makeObject();
+                args.set("detail", JsonValue::makeString(span.detail));
+                event.set("args", move(args));
+            }
+            writeEvent(event);
+        }
+
+        // ORT event timestamps are microseconds since the session's profiling start.
+        for (size_t i = 0; i < profiles.size(); ++i)
+        {
+            const int pid = (int)i + 2;
+            writeEvent(metadataEvent(pid, "ONNX Runtime: " + profiles[i].modelName));
+            JsonValue ortEvents;
+            try {
+                ortEvents = JsonReader::parseFile(profiles[i].path);
+            }
+            catch (const exception& e) {
+                cerr << "Warning: skipping ONNX Runtime profile " << profiles[i].path << ": " << e.what() << endl;
+                continue;
+            }
+            const double offsetUs = (profiles[i].startNs - origin) / 1000.0;
+            for (JsonValue& event : ortEvents.items)
+            {
+                if (!event.isObject())
+                    continue;
+                event.set("ts", JsonValue::makeNumber(event.numberOr("ts", 0) + offsetUs));
+                event.set("pid", JsonValue::makeNumber(pid));
+                writeEvent(event);
+            }
+        }
+        file << "\n]}\n";
+    }
+};
+
+// Records the enclosing scope as a harness span when tracing is enabled; costs one relaxed load otherwise.
+class TraceSpan
+{
+private:
+    const char* category;
+    const char* name;
+    string detail;
+    int64_t startNs = 0;
+
+public:
+    TraceSpan(const char* category, const char* name, const string& detail = "")
+        : category(category), name(name)
+    {
+        if (TraceRecorder::instance().isEnabled())
+        {
+            this->detail = detail;
+            startNs = traceClockNs();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (startNs != 0)
+            TraceRecorder::instance().recordSpan(category, name, startNs, traceClockNs(), detail);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif // AI_BMT_TRACE_H
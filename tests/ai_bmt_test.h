@@ -0,0 +1,87 @@
+#ifndef AI_BMT_TEST_H
+#define AI_BMT_TEST_H
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+using namespace std;
+
+// Minimal checks for the executables in tests/ (one per component, registered with CTest).
+// A failed check prints its location and the test's main returns testResult() != 0; nothing is aborted,
+// so one run reports every failing check.
+inline int& testFailureCount()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void reportTestFailure(const char* file, int line, const char* expression)
+{
+    ++testFailureCount();
+    cerr << file << ":" << line << ": check failed: " << expression << endl;
+}
+
+inline int testResult()
+{
+    if (testFailureCount() == 0)
+        return 0;
+    cerr << testFailureCount() << " check(s) failed" << endl;
+    return 1;
+}
+
+#define AI_BMT_CHECK(condition) \
+    do { if (!(condition)) reportTestFailure(__FILE__, __LINE__, #condition); } while (0)
+
+// |actual - expected| <= tolerance * max(1, |expected|)
+#define AI_BMT_CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        const double checkActual = (double)(actual), checkExpected = (double)(expected); \
+        if (!(fabs(checkActual - checkExpected) <= (tolerance) * fmax(1.0, fabs(checkExpected)))) \
+        { \
+            reportTestFailure(__FILE__, __LINE__, #actual " ~ " #expected); \
+            cerr << "  actual " << checkActual << ", expected " << checkExpected << endl; \
+        } \
+    } while (0)
+
+#define AI_BMT_CHECK_THROWS(expression) \
+    do { \
+        bool checkThrew = false; \
+        try { (void)(expression); } catch (...) { checkThrew = true; } \
+        if (!checkThrew) reportTestFailure(__FILE__, __LINE__, #expression " throws"); \
+    } while (0)
+
+// Fixed-seed inputs, identical on every platform (mt19937 output is specified by the standard; distributions are not).
+class TestRandom
+{
+private:
+    mt19937 engine;
+
+public:
+    explicit TestRandom(uint32_t seed = 12345) : engine(seed) {}
+
+    uint32_t next() { return (uint32_t)engine(); }
+
+    // Uniform in [low, high)
+    float uniform(float low, float high) { return low + (high - low) * (float)(next() >> 8) / 16777216.0f; }
+
+    template <typename T>
+    vector<T> bytes(size_t count)
+    {
+        vector<T> values(count);
+        for (T& value : values)
+            value = (T)next();
+        return values;
+    }
+
+    vector<float> floats(size_t count, float low, float high)
+    {
+        vector<float> values(count);
+        for (float& value : values)
+            value = uniform(low, high);
+        return values;
+    }
+};
+
+#endif // AI_BMT_TEST_H
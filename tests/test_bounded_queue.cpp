@@ -0,0 +1,77 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_bounded_queue.h"
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    // FIFO order, byte accounting and peak.
+    {
+        BoundedByteQueue<int> queue(100);
+        AI_BMT_CHECK(queue.push(1, 40));
+        AI_BMT_CHECK(queue.push(2, 60));
+        int item = 0;
+        size_t bytes = 0;
+        AI_BMT_CHECK(queue.pop(item, bytes) && item == 1 && bytes == 40);
+        AI_BMT_CHECK(queue.pop(item, bytes) && item == 2 && bytes == 60);
+        AI_BMT_CHECK(queue.peakChargedBytes() == 100);
+        queue.release(100, 2);
+        AI_BMT_CHECK(queue.push(3, 100));
+        AI_BMT_CHECK(queue.peakChargedBytes() == 100);
+    }
+
+    // Items larger than the budget are still admitted while fewer than minInFlight are held.
+    {
+        BoundedByteQueue<int> queue(10, 2);
+        AI_BMT_CHECK(queue.push(1, 1000));
+        AI_BMT_CHECK(queue.push(2, 1000));
+        AI_BMT_CHECK(queue.peakChargedBytes() == 2000);
+    }
+
+    // A producer thread runs ahead of the consumer only as far as the budget allows; popped items stay
+    // charged until released.
+    {
+        const int itemCount = 500;
+        const size_t itemBytes = 30;
+        const size_t budget = 100;
+        BoundedByteQueue<int> queue(budget);
+        thread producer([&] {
+            for (int i = 0; i < itemCount; ++i)
+                queue.push(i, itemBytes);
+            queue.close();
+        });
+        int item = 0;
+        size_t bytes = 0;
+        int expected = 0;
+        while (queue.pop(item, bytes))
+        {
+            AI_BMT_CHECK(item == expected);
+            ++expected;
+            queue.release(bytes);
+        }
+        producer.join();
+        AI_BMT_CHECK(expected == itemCount);
+        AI_BMT_CHECK(queue.peakChargedBytes() <= budget);
+        AI_BMT_CHECK(queue.peakChargedBytes() >= itemBytes);
+    }
+
+    // close() rejects a producer waiting for budget and lets the consumer drain what is queued.
+    {
+        BoundedByteQueue<int> queue(50);
+        AI_BMT_CHECK(queue.push(1, 40));
+        bool pushed = true;
+        thread producer([&] { pushed = queue.push(2, 40); });
+        queue.close();
+        producer.join();
+        AI_BMT_CHECK(!pushed);
+        int item = 0;
+        size_t bytes = 0;
+        AI_BMT_CHECK(queue.pop(item, bytes) && item == 1);
+        AI_BMT_CHECK(!queue.pop(item, bytes));
+        AI_BMT_CHECK(!queue.push(3, 1));
+    }
+
+    return testResult();
+}
@@ -0,0 +1,84 @@
+#include "ai_bmt_test.h"
+#include "Image_Preprocessing.h"
+#include <vector>
+
+using namespace std;
+
+// Reference: (pixel * scale - mean) / std per channel, BGR in, planar RGB out.
+static void convertReference(const vector<uint8_t>& bgr, int height, int width, size_t rowStride,
+    const float mean[3], const float stddev[3], float scale, vector<float>& output)
+{
+    const size_t planeSize = (size_t)height * width;
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            for (int c = 0; c < 3; ++c)
+            {
+                const uint8_t pixel = bgr[y * rowStride + 3 * x + (2 - c)];
+                output[c * planeSize + (size_t)y * width + x] = (pixel * scale - mean[c]) / stddev[c];
+            }
+}
+
+static void checkSize(TestRandom& random, int height, int width, size_t padding)
+{
+    const float mean[3] = { 0.485f, 0.456f, 0.406f };
+    const float stddev[3] = { 0.229f, 0.224f, 0.225f };
+    const ChannelNormalization normalization = ChannelNormalization::fromMeanStd(mean, stddev, 1.0f / 255);
+    const size_t rowStride = 3 * (size_t)width + padding;
+    const vector<uint8_t> bgr = random.bytes<uint8_t>(rowStride * height);
+    const size_t count = 3 * (size_t)height * width;
+
+    vector<float> expected(count);
+    convertReference(bgr, height, width, rowStride, mean, stddev, 1.0f / 255, expected);
+
+    vector<float> scalar(count, -1000.0f);
+    convertBgrToNormalizedPlanarRgb(bgr.data(), height, width, rowStride, normalization, scalar.data(), PreprocessingSimdLevel::Scalar);
+    for (size_t i = 0; i < count; ++i)
+        AI_BMT_CHECK_NEAR(scalar[i], expected[i], 1e-5);
+
+    // The SIMD kernels use FMA, so they may differ from the scalar multiply-add in the last bit only,
+    // and the AVX-512 kernels match the AVX2 one exactly.
+    if (preprocessingSimdLevel() == PreprocessingSimdLevel::Scalar)
+        return;
+    vector<float> avx2(count, -1000.0f);
+    convertBgrToNormalizedPlanarRgb(bgr.data(), height, width, rowStride, normalization, avx2.data(), PreprocessingSimdLevel::AVX2);
+    for (size_t i = 0; i < count; ++i)
+        AI_BMT_CHECK_NEAR(avx2[i], scalar[i], 1e-6);
+    for (PreprocessingSimdLevel level : { PreprocessingSimdLevel::AVX512BW, PreprocessingSimdLevel::AVX512VBMI })
+    {
+        if (level > preprocessingSimdLevel())
+            continue;
+        vector<float> avx512(count, -1000.0f);
+        convertBgrToNormalizedPlanarRgb(bgr.data(), height, width, rowStride, normalization, avx512.data(), level);
+        AI_BMT_CHECK(avx512 == avx2);
+    }
+}
+
+int main()
+{
+    TestRandom random;
+    // Widths around the 16- and 64-pixel SIMD blocks exercise the tails; padded rows check that rowStride is honoured.
+    for (int width : { 1, 15, 16, 17, 31, 48, 63, 64, 65, 67, 127, 128, 129, 224 })
+    {
+        checkSize(random, 3, width, 0);
+        checkSize(random, 2, width, 5);
+    }
+    checkSize(random, 520, 520, 0);
+
+    // Every byte value maps to the same float on every path, with B, G and R kept apart.
+    vector<uint8_t> ramp(3 * 256);
+    for (size_t i = 0; i < ramp.size(); ++i)
+        ramp[i] = (uint8_t)(i / 3 + (2 - i % 3));
+    const float mean[3] = { 0.0f, 0.0f, 0.0f };
+    const float stddev[3] = { 1.0f, 1.0f, 1.0f };
+    const ChannelNormalization identity = ChannelNormalization::fromMeanStd(mean, stddev, 1.0f);
+    for (int level = 0; level <= (int)preprocessingSimdLevel(); ++level)
+    {
+        vector<float> output(3 * 256);
+        convertBgrToNormalizedPlanarRgb(ramp.data(), 1, 256, ramp.size(), identity, output.data(), (PreprocessingSimdLevel)level);
+        for (size_t x = 0; x < 256; ++x)
+            for (size_t c = 0; c < 3; ++c)
+                AI_BMT_CHECK(output[c * 256 + x] == (float)(uint8_t)(x + c));
+    }
+
+    return testResult();
+}
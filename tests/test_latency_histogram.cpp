@@ -0,0 +1,128 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_latency_histogram.h"
+#include "ai_bmt_stage_timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Nearest-rank percentile of sorted values, the definition percentileNs(..) approximates.
+static uint64_t exactPercentile(const vector<uint64_t>& sorted, double p)
+{
+    uint64_t rank = (uint64_t)ceil(p / 100.0 * sorted.size());
+    rank = min<uint64_t>(max<uint64_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+int main()
+{
+    // Heap-allocated: a histogram holds several thousand buckets.
+    auto histogram = make_unique<LatencyHistogram>();
+    AI_BMT_CHECK(histogram->count() == 0);
+    AI_BMT_CHECK(histogram->percentileNs(50) == 0);
+    AI_BMT_CHECK(histogram->minNs() == 0 && histogram->maxNs() == 0);
+
+    // Values below 256 ns are exact.
+    for (uint64_t ns = 1; ns <= 100; ++ns)
+        histogram->record(ns);
+    AI_BMT_CHECK(histogram->count() == 100);
+    AI_BMT_CHECK(histogram->sumNs() == 5050);
+    AI_BMT_CHECK(histogram->minNs() == 1 && histogram->maxNs() == 100);
+    AI_BMT_CHECK(histogram->percentileNs(0) == 1);
+    AI_BMT_CHECK(histogram->percentileNs(50) == 50);
+    AI_BMT_CHECK(histogram->percentileNs(90) == 90);
+    AI_BMT_CHECK(histogram->percentileNs(99) == 99);
+    AI_BMT_CHECK(histogram->percentileNs(99.9) == 100);
+    AI_BMT_CHECK(histogram->percentileNs(100) == 100);
+
+    // Larger values, log-uniform from 1 us to 10 s: every percentile lies within the bucket precision
+    // (at most 1/128 above the exact value) and never outside [min, max].
+    histogram->reset();
+    AI_BMT_CHECK(histogram->count() == 0);
+    TestRandom random;
+    vector<uint64_t> values(20000);
+    for (uint64_t& value : values)
+    {
+        value = (uint64_t)pow(10.0, random.uniform(3.0f, 10.0f));
+        histogram->record(value);
+    }
+    sort(values.begin(), values.end());
+    for (double p : { 0.0, 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0 })
+    {
+        const uint64_t exact = exactPercentile(values, p);
+        const uint64_t reported = histogram->percentileNs(p);
+        AI_BMT_CHECK(reported >= exact);
+        AI_BMT_CHECK(reported <= exact + exact / 128);
+        AI_BMT_CHECK(reported >= values.front() && reported <= values.back());
+    }
+    AI_BMT_CHECK(histogram->percentileNs(100) == values.back());
+
+    // Durations are converted to nanoseconds; negative ones count as 0.
+    histogram->reset();
+    histogram->record(chrono::microseconds(3));
+    histogram->record(chrono::nanoseconds(-5));
+    AI_BMT_CHECK(histogram->minNs() == 0 && histogram->maxNs() == 3000);
+
+    // Concurrent record() loses nothing, and a copy is a snapshot.
+    histogram->reset();
+    vector<thread> threads;
+    for (uint64_t t = 0; t < 4; ++t)
+        threads.emplace_back([&histogram, t] {
+            for (uint64_t i = 1; i <= 10000; ++i)
+                histogram->record(i * 100 + t);
+        });
+    for (thread& worker : threads)
+        worker.join();
+    AI_BMT_CHECK(histogram->count() == 40000);
+    AI_BMT_CHECK(histogram->sumNs() == 4 * (100ull * 10000 * 10001 / 2) + 10000ull * (0 + 1 + 2 + 3));
+    AI_BMT_CHECK(histogram->minNs() == 100 && histogram->maxNs() == 1000003);
+    auto snapshot = make_unique<LatencyHistogram>(*histogram);
+    histogram->record(5);
+    AI_BMT_CHECK(snapshot->count() == 40000 && snapshot->minNs() == 100);
+    AI_BMT_CHECK(snapshot->percentileNs(50) == histogram->percentileNs(50));
+
+    // The recorder hands out one histogram per name, in order of first use.
+    LatencyRecorder& recorder = LatencyRecorder::instance();
+    LatencyHistogram& first = recorder.histogram("test.first");
+    LatencyHistogram& second = recorder.histogram("test.second");
+    AI_BMT_CHECK(&recorder.histogram("test.first") == &first);
+    AI_BMT_CHECK(&first != &second);
+    first.record(10);
+    recorder.reset();
+    AI_BMT_CHECK(first.count() == 0);
+    const auto entries = recorder.snapshot();
+    AI_BMT_CHECK(entries.size() == 2 && entries[0].first == "test.first" && entries[1].second == &second);
+
+    // Histograms with too few samples for tail percentiles are named below the table.
+    for (int i = 0; i < 3; ++i)
+        first.record(1000);
+    ostringstream table;
+    recorder.printPercentiles(table);
+    AI_BMT_CHECK(table.str().find("fewer than 100 samples in test.first (3)") != string::npos);
+    for (int i = 0; i < 97; ++i)
+        first.record(1000);
+    table.str("");
+    recorder.printPercentiles(table);
+    AI_BMT_CHECK(table.str().find("Warning") == string::npos);
+
+    // Stage timers record only while enabled at run time.
+    auto runStage = [] { AI_BMT_SCOPED_STAGE("stage.test"); };
+    LatencyHistogram& stage = recorder.histogram("stage.test");
+    enableStageTimers(false);
+    runStage();
+    AI_BMT_CHECK(stage.count() == 0);
+    enableStageTimers(true);
+    runStage();
+    runStage();
+    AI_BMT_CHECK(stage.count() == 2);
+    enableStageTimers(false);
+    runStage();
+    AI_BMT_CHECK(stage.count() == 2);
+
+    return testResult();
+}
@@ -0,0 +1,69 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_perf_counters.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// A thread that exists before the counters are enabled, like a runtime pool thread created at Initialize.
+// It waits for start(), optionally excludes itself from the process-wide counters, then keeps a core busy for 100 ms.
+class SpinningThread
+{
+private:
+    atomic<int> state{ 0 }; // 0 = waiting, 1 = started, 2 = ready to spin, 3 = spin
+    thread worker;
+
+public:
+    explicit SpinningThread(bool exclude)
+        : worker([this, exclude] {
+            while (state.load() == 0)
+                this_thread::sleep_for(chrono::milliseconds(1));
+            if (exclude)
+                HardwareCounterRecorder::instance().excludeCallingThread();
+            state = 2;
+            while (state.load() != 3)
+                this_thread::yield();
+            const auto end = chrono::steady_clock::now() + chrono::milliseconds(100);
+            volatile uint64_t sink = 0;
+            while (chrono::steady_clock::now() < end)
+                sink = sink + 1;
+        })
+    {
+    }
+
+    // CPU milliseconds the process-wide counters charge while the thread spins.
+    double chargedCpuMs()
+    {
+        HardwareCounterRecorder& counters = HardwareCounterRecorder::instance();
+        state = 1;
+        while (state.load() != 2)
+            this_thread::yield();
+        HardwareCounterRecorder::Sample start = counters.sampleProcess();
+        state = 3;
+        worker.join();
+        HardwareCounterRecorder::Sample end = counters.sampleProcess();
+        return (end.counters - start.counters).values[PerfCounterValues::TaskClock] / 1e6;
+    }
+};
+
+int main()
+{
+    SpinningThread counted(false);
+    SpinningThread excluded(true);
+    string reason;
+    if (!HardwareCounterRecorder::instance().enable(reason))
+    {
+        cout << "Hardware counters unavailable (" << reason << "); skipped" << endl;
+        counted.chargedCpuMs();
+        excluded.chargedCpuMs();
+        return testResult();
+    }
+
+    // Threads that existed at enable() are charged, unless they exclude themselves (e.g., --stream preprocessing).
+    AI_BMT_CHECK(counted.chargedCpuMs() > 50);
+    AI_BMT_CHECK(excluded.chargedCpuMs() < 50);
+    return testResult();
+}
@@ -0,0 +1,147 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_preprocessed_cache.h"
+#include "ai_bmt_thread_pool.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+using namespace std;
+
+static const function<void(size_t, const function<void(size_t)>&)> sequential = [](size_t count, const function<void(size_t)>& body) {
+    for (size_t i = 0; i < count; ++i)
+        body(i);
+};
+
+static void writeFile(const filesystem::path& path, const vector<uint8_t>& content)
+{
+    ofstream file(path, ios::binary | ios::trunc);
+    file.write((const char*)content.data(), (streamsize)content.size());
+}
+
+// Query i of the fake dataset: 3 x 5 x 7 floats derived from i, so every entry differs.
+static vector<float> queryValues(size_t i)
+{
+    vector<float> values(3 * 5 * 7);
+    for (size_t k = 0; k < values.size(); ++k)
+        values[k] = (float)i * 1000.0f + (float)k * 0.5f;
+    return values;
+}
+
+static bool entryMatches(const PreprocessedCache& cache, size_t i)
+{
+    const VariantType entry = cache.entry(i);
+    const vector<float> expected = queryValues(i);
+    const float* data = nullptr;
+    if (holds_alternative<float*>(entry))
+        data = get<float*>(entry);
+    else if (holds_alternative<TensorView>(entry))
+    {
+        const TensorView& view = get<TensorView>(entry);
+        if (view.dtype != TensorDataType::Float32 || view.shape != vector<int64_t>{ 3, 5, 7 } || view.ownsData())
+            return false;
+        data = (const float*)view.data;
+    }
+    if (data == nullptr || (uintptr_t)data % PreprocessedCache::Alignment != 0)
+        return false;
+    return equal(expected.begin(), expected.end(), data);
+}
+
+int main()
+{
+    const filesystem::path directory = filesystem::temp_directory_path() / "ai_bmt_test_preprocessed_cache";
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+
+    TestRandom random;
+    vector<string> imagePaths;
+    for (int i = 0; i < 6; ++i)
+    {
+        const filesystem::path path = directory / ("image" + to_string(i) + ".jpg");
+        writeFile(path, random.bytes<uint8_t>(100 + 37 * i));
+        imagePaths.push_back(path.string());
+    }
+    const string cachePath = (directory / "dataset.cache").string();
+    const string signature = "mean=0,0,0;std=1,1,1;size=5x7";
+    string reason;
+
+    // Missing file
+    {
+        PreprocessedCache cache;
+        AI_BMT_CHECK(!cache.open(cachePath, imagePaths, signature, sequential, reason));
+        AI_BMT_CHECK(reason == "no cache file");
+    }
+
+    // vector<float> queries come back as float* into the mapping, built on a thread pool.
+    {
+        WorkStealingThreadPool pool(3);
+        PreprocessedCache::build(cachePath, imagePaths, signature,
+            [](size_t i) { return VariantType(queryValues(i)); },
+            [&pool](size_t count, const function<void(size_t)>& body) { pool.parallelFor(count, body); });
+        PreprocessedCache cache;
+        reason = "left over from an earlier call";
+        AI_BMT_CHECK(cache.open(cachePath, imagePaths, signature, sequential, reason));
+        AI_BMT_CHECK(cache.entryCount() == imagePaths.size());
+        AI_BMT_CHECK(cache.entryBytes() == 3 * 5 * 7 * sizeof(float));
+        for (size_t i = 0; i < imagePaths.size(); ++i)
+        {
+            AI_BMT_CHECK(holds_alternative<float*>(cache.entry(i)));
+            AI_BMT_CHECK(entryMatches(cache, i));
+        }
+    }
+
+    // TensorView queries keep their shape.
+    {
+        PreprocessedCache::build(cachePath, imagePaths, signature,
+            [](size_t i) { return VariantType(TensorView::wrap(queryValues(i), { 3, 5, 7 })); }, sequential);
+        PreprocessedCache cache;
+        AI_BMT_CHECK(cache.open(cachePath, imagePaths, signature, sequential, reason));
+        for (size_t i = 0; i < imagePaths.size(); ++i)
+        {
+            AI_BMT_CHECK(holds_alternative<TensorView>(cache.entry(i)));
+            AI_BMT_CHECK(entryMatches(cache, i));
+        }
+    }
+
+    // Stale caches are reported, not reused.
+    {
+        PreprocessedCache cache;
+        AI_BMT_CHECK(!cache.open(cachePath, imagePaths, signature + ";changed", sequential, reason));
+        AI_BMT_CHECK(reason == "preprocessing parameters changed");
+
+        vector<string> fewerImages(imagePaths.begin(), imagePaths.end() - 1);
+        AI_BMT_CHECK(!cache.open(cachePath, fewerImages, signature, sequential, reason));
+        AI_BMT_CHECK(reason == "dataset size changed");
+
+        writeFile(imagePaths[4], random.bytes<uint8_t>(100 + 37 * 4));
+        AI_BMT_CHECK(!cache.open(cachePath, imagePaths, signature, sequential, reason));
+        AI_BMT_CHECK(reason == "source image changed: " + imagePaths[4]);
+        AI_BMT_CHECK(cache.entryCount() == 0);
+
+        // Rebuilding over the stale file makes it valid again.
+        PreprocessedCache::build(cachePath, imagePaths, signature, [](size_t i) { return VariantType(queryValues(i)); }, sequential);
+        AI_BMT_CHECK(cache.open(cachePath, imagePaths, signature, sequential, reason));
+        AI_BMT_CHECK(entryMatches(cache, 4));
+    }
+
+    // Truncated files
+    {
+        filesystem::resize_file(cachePath, filesystem::file_size(cachePath) - 1);
+        PreprocessedCache cache;
+        AI_BMT_CHECK(!cache.open(cachePath, imagePaths, signature, sequential, reason));
+        AI_BMT_CHECK(reason == "truncated data");
+        filesystem::resize_file(cachePath, 16);
+        AI_BMT_CHECK(!cache.open(cachePath, imagePaths, signature, sequential, reason));
+        AI_BMT_CHECK(reason == "truncated header");
+    }
+
+    // Queries of different sizes and raw pointers cannot be cached.
+    AI_BMT_CHECK_THROWS(PreprocessedCache::build(cachePath, imagePaths, signature,
+        [](size_t i) { return VariantType(vector<float>(10 + i)); }, sequential));
+    AI_BMT_CHECK_THROWS(PreprocessedCache::build(cachePath, imagePaths, signature,
+        [](size_t) { return VariantType((float*)nullptr); }, sequential));
+
+    filesystem::remove_all(directory);
+    return testResult();
+}
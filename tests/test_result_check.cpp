@@ -0,0 +1,158 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_result_check.h"
+#include "Result_Encoding.h"
+#include <vector>
+
+using namespace std;
+
+static void checkOutputSummary()
+{
+    ResultOutputSummary summary;
+    BMTResult raw;
+    raw.objectDetectionResult.resize(1000);
+    summary.add(raw, nullptr);
+    AI_BMT_CHECK(summary.meanBytes() == 4000 && summary.boxQueries() == 0);
+
+    // A query answered with boxes counts even when it has none.
+    BMTResult compact;
+    BMTResultExtras boxes;
+    boxes.objectDetectionBoxes.resize(3);
+    const BMTResultExtras noBoxes;
+    summary.add(compact, &boxes);
+    summary.add(compact, &noBoxes);
+    AI_BMT_CHECK(summary.queries() == 3 && summary.boxQueries() == 2);
+    AI_BMT_CHECK_NEAR(summary.meanBoxes(), 1.5, 1e-12);
+    AI_BMT_CHECK_NEAR(summary.meanBytes(), (4000.0 + 3 * sizeof(Coco17DetectionResult)) / 3, 1e-9);
+
+    // Class maps are a byte per pixel and hold no boxes.
+    BMTResultExtras classMap;
+    classMap.segmentationClassMap.resize(520 * 520);
+    ResultOutputSummary segmentation;
+    segmentation.add(compact, &classMap);
+    AI_BMT_CHECK(segmentation.meanBytes() == 520 * 520 && segmentation.boxQueries() == 0);
+}
+
+static void checkBoxes()
+{
+    const vector<Coco17DetectionResult> expected = {
+        { 1, 10, 10, 100, 100, 0.9f },
+        { 1, 300, 300, 50, 50, 0.6f },
+        { 2, 10, 10, 100, 100, 0.5f },
+    };
+
+    // Same boxes in another order, slightly moved: all match.
+    ResultCheck same;
+    same.addBoxes(expected, { expected[2], { 1, 301, 300, 50, 50, 0.605f }, expected[0] });
+    AI_BMT_CHECK(same.passed() && same.boxes().matched == 3);
+    AI_BMT_CHECK(same.boxes().minIoU > 0.95f && same.boxes().minIoU < 1.0f);
+
+    // A missing box, a wrong class and an extra box all fail.
+    ResultCheck missing;
+    missing.addBoxes(expected, { expected[0], expected[1] });
+    AI_BMT_CHECK(!missing.passed() && missing.boxes().matched == 2);
+    ResultCheck wrongClass;
+    wrongClass.addBoxes(expected, { expected[0], expected[1], { 3, 10, 10, 100, 100, 0.5f } });
+    AI_BMT_CHECK(!wrongClass.passed() && wrongClass.boxes().matched == 2);
+    ResultCheck extra;
+    extra.addBoxes(expected, { expected[0], expected[1], expected[2], { 0, 500, 500, 10, 10, 0.3f } });
+    AI_BMT_CHECK(!extra.passed() && extra.boxes().returned == 4);
+
+    // Two boxes cannot match the same returned box, and far or differently scored boxes do not match.
+    ResultCheck duplicate;
+    duplicate.addBoxes({ expected[0], expected[0] }, { expected[0] });
+    AI_BMT_CHECK(!duplicate.passed() && duplicate.boxes().matched == 1);
+    ResultCheck moved;
+    moved.addBoxes({ expected[0] }, { { 1, 30, 30, 100, 100, 0.9f } });
+    AI_BMT_CHECK(!moved.passed());
+    ResultCheck rescored;
+    rescored.addBoxes({ expected[0] }, { { 1, 10, 10, 100, 100, 0.8f } });
+    AI_BMT_CHECK(!rescored.passed());
+
+    // Queries without boxes on either side pass.
+    ResultCheck none;
+    none.addBoxes({}, {});
+    AI_BMT_CHECK(none.passed() && !none.empty());
+}
+
+static void checkClassMaps()
+{
+    // 3 classes x 4 pixels; pixel 3 ties classes 1 and 2.
+    const vector<float> logits = {
+        0.9f, 0.1f, 0.2f, 0.0f,
+        0.5f, 0.8f, 0.1f, 0.7f,
+        0.1f, 0.3f, 0.6f, 0.7f,
+    };
+    ResultCheck same;
+    same.addClassMap(logits, { 0, 1, 2, 1 });
+    AI_BMT_CHECK(same.passed() && same.classMaps().agreement() == 1.0 && same.classMaps().channels == 3);
+
+    ResultCheck tieBroken;
+    tieBroken.addClassMap(logits, { 0, 1, 2, 2 });
+    AI_BMT_CHECK(!tieBroken.passed() && tieBroken.classMaps().agreeing == 3);
+
+    // The planes must divide the logits evenly.
+    ResultCheck wrongSize;
+    wrongSize.addClassMap(logits, { 0, 1, 2, 1, 0 });
+    AI_BMT_CHECK(!wrongSize.passed() && wrongSize.classMaps().sizeMismatches == 1);
+
+    // One flipped pixel in 10000 is within the limit, eleven are not.
+    const size_t planeSize = 10000;
+    vector<float> planes(2 * planeSize, 0.0f);
+    for (size_t p = 0; p < planeSize; ++p)
+        planes[planeSize + p] = 1.0f;
+    vector<uint8_t> map(planeSize, 1);
+    map[17] = 0;
+    ResultCheck oneFlip;
+    oneFlip.addClassMap(planes, map);
+    AI_BMT_CHECK(oneFlip.passed());
+    for (size_t p = 100; p < 110; ++p)
+        map[p] = 0;
+    ResultCheck elevenFlips;
+    elevenFlips.addClassMap(planes, map);
+    AI_BMT_CHECK(!elevenFlips.passed());
+}
+
+static void checkEncoded(TestRandom& random)
+{
+    vector<float> raw(4096);
+    for (float& value : raw)
+        value = random.uniform(-20.0f, 35.0f);
+
+    for (EncodedTensor::Encoding encoding : { EncodedTensor::Encoding::Float16, EncodedTensor::Encoding::Int8 })
+    {
+        ResultEncoder encoder;
+        encoder.reset(encoding, raw.size(), 1);
+        EncodedTensor encoded;
+        encoder.encode(raw.data(), raw.size(), encoded);
+
+        ResultCheck check;
+        check.addEncoded(raw, encoded);
+        AI_BMT_CHECK(check.passed() && check.encodedOutputs().values == raw.size());
+        AI_BMT_CHECK(check.encodedOutputs().maxAbsError > 0);
+        AI_BMT_CHECK(check.encodedOutputs().encodedBytes * (encoding == EncodedTensor::Encoding::Float16 ? 2 : 4) == check.encodedOutputs().rawBytes);
+
+        BMTResultExtras extras;
+        extras.segmentationResultEncoded = encoded;
+        AI_BMT_CHECK(resultPayloadBytes(BMTResult(), &extras) == check.encodedOutputs().encodedBytes && !holdsBoxes(extras));
+
+        // A raw output that moved by more than the rounding error, or has another size, fails.
+        vector<float> moved = raw;
+        moved[100] += 0.5f;
+        ResultCheck far;
+        far.addEncoded(moved, encoded);
+        AI_BMT_CHECK(!far.passed() && far.encodedOutputs().outOfTolerance == 1);
+        ResultCheck shorter;
+        shorter.addEncoded(vector<float>(raw.begin(), raw.end() - 1), encoded);
+        AI_BMT_CHECK(!shorter.passed() && shorter.encodedOutputs().sizeMismatches == 1);
+    }
+}
+
+int main()
+{
+    TestRandom random;
+    checkOutputSummary();
+    checkBoxes();
+    checkClassMaps();
+    checkEncoded(random);
+    return testResult();
+}
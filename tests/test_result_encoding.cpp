@@ -0,0 +1,151 @@
+#include "ai_bmt_test.h"
+#include "Result_Encoding.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+// IEEE 754 half -> float by its definition, independent of the bit manipulation in halfToFloat.
+static float halfReference(uint16_t half)
+{
+    const float sign = (half & 0x8000) ? -1.0f : 1.0f;
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+    if (exponent == 0x1F)
+        return mantissa == 0 ? sign * numeric_limits<float>::infinity() : numeric_limits<float>::quiet_NaN();
+    if (exponent == 0)
+        return sign * ldexpf((float)mantissa, -24);
+    return sign * ldexpf((float)(1024 + mantissa), exponent - 25);
+}
+
+static bool sameBits(float a, float b)
+{
+    uint32_t x;
+    uint32_t y;
+    memcpy(&x, &a, sizeof(x));
+    memcpy(&y, &b, sizeof(y));
+    return x == y;
+}
+
+// Random values plus the cases where rounding differs most easily: signed zeros, subnormals, values halfway
+// between two halves, the largest half and overflow to infinity.
+static vector<float> encodingInputs(TestRandom& random, size_t count)
+{
+    vector<float> values = random.floats(count, -8.0f, 8.0f);
+    const float special[] = { 0.0f, -0.0f, 1.0f, -1.0f, 5.96e-8f, 6.1e-5f, -3.0e-6f, 1.0f + 1.0f / 2048, 1.0f + 3.0f / 2048,
+        65504.0f, 65520.0f, 1.0e6f, -1.0e6f, numeric_limits<float>::infinity(), -numeric_limits<float>::infinity() };
+    for (size_t i = 0; i < sizeof(special) / sizeof(special[0]) && i < count; ++i)
+        values[i * 3 % count] = special[i];
+    return values;
+}
+
+static void checkHalfToFloat()
+{
+    for (uint32_t half = 0; half <= 0xFFFF; ++half)
+    {
+        const float value = halfToFloat((uint16_t)half);
+        const float expected = halfReference((uint16_t)half);
+        AI_BMT_CHECK((isnan(value) && isnan(expected)) || sameBits(value, expected));
+    }
+}
+
+static void checkFloat16(TestRandom& random, size_t count)
+{
+    const vector<float> input = encodingInputs(random, count);
+    ResultEncoder scalarEncoder;
+    scalarEncoder.reset(EncodedTensor::Encoding::Float16, count, 1, PreprocessingSimdLevel::Scalar);
+    EncodedTensor scalar;
+    scalarEncoder.encode(input.data(), count, scalar);
+    AI_BMT_CHECK(scalar.encoding == EncodedTensor::Encoding::Float16 && scalar.size() == count);
+
+    // Round to nearest: the half is within half an ulp (2^-11 relative) of the input, or saturates to infinity.
+    const DequantizedView view(scalar);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (fabs(input[i]) >= 65520.0f)
+            AI_BMT_CHECK(isinf(view[i]) && (view[i] > 0) == (input[i] > 0));
+        else if (fabs(input[i]) >= 6.1035e-5f)
+            AI_BMT_CHECK_NEAR(view[i], input[i], 1.0 / 2048);
+        else
+            AI_BMT_CHECK(fabs(view[i] - input[i]) <= 2.98e-8f); // Subnormal step 2^-24
+    }
+
+    if (preprocessingSimdLevel() == PreprocessingSimdLevel::Scalar)
+        return;
+    ResultEncoder simdEncoder;
+    simdEncoder.reset(EncodedTensor::Encoding::Float16, count, 1, PreprocessingSimdLevel::AVX2);
+    EncodedTensor simd;
+    simdEncoder.encode(input.data(), count, simd);
+    AI_BMT_CHECK(simd.float16Data == scalar.float16Data);
+}
+
+static void checkInt8(TestRandom& random, size_t count, float low, float high)
+{
+    const vector<float> input = random.floats(count, low, high);
+    ResultEncoder scalarEncoder;
+    scalarEncoder.reset(EncodedTensor::Encoding::Int8, count, 1, PreprocessingSimdLevel::Scalar);
+    EncodedTensor scalar;
+    scalarEncoder.encode(input.data(), count, scalar);
+    AI_BMT_CHECK(scalar.encoding == EncodedTensor::Encoding::Int8 && scalar.size() == count);
+
+    // The range includes 0, so 0 is exact; every value is within half a step of its input.
+    AI_BMT_CHECK(scalar.scale > 0);
+    AI_BMT_CHECK(scalar.zeroPoint >= -128 && scalar.zeroPoint <= 127);
+    const DequantizedView view(scalar);
+    vector<float> copied(count);
+    view.copyTo(0, count, copied.data());
+    for (size_t i = 0; i < count; ++i)
+    {
+        AI_BMT_CHECK(fabs(view[i] - input[i]) <= scalar.scale * 0.5f + 1e-6f * fabs(input[i]));
+        AI_BMT_CHECK(copied[i] == view[i]);
+    }
+
+    if (preprocessingSimdLevel() == PreprocessingSimdLevel::Scalar)
+        return;
+    ResultEncoder simdEncoder;
+    simdEncoder.reset(EncodedTensor::Encoding::Int8, count, 1, PreprocessingSimdLevel::AVX2);
+    EncodedTensor simd;
+    simdEncoder.encode(input.data(), count, simd);
+    AI_BMT_CHECK(simd.scale == scalar.scale && simd.zeroPoint == scalar.zeroPoint);
+    AI_BMT_CHECK(simd.int8Data == scalar.int8Data);
+}
+
+int main()
+{
+    checkHalfToFloat();
+
+    TestRandom random;
+    // Counts around the 8-value block exercise the scalar tails.
+    for (size_t count : { 16, 17, 23, 64, 1000 })
+        checkFloat16(random, count);
+    for (size_t count : { 1, 7, 8, 9, 1000, 25200 * 85 })
+    {
+        checkInt8(random, count, -3.0f, 5.0f);
+        checkInt8(random, count, 0.5f, 2.0f);
+        checkInt8(random, count, -40.0f, -1.0f);
+    }
+
+    // An all-zero tensor gets a valid scale and decodes to zeros.
+    ResultEncoder encoder;
+    encoder.reset(EncodedTensor::Encoding::Int8, 32, 1);
+    const vector<float> zeros(32, 0.0f);
+    EncodedTensor encoded;
+    encoder.encode(zeros.data(), zeros.size(), encoded);
+    AI_BMT_CHECK(encoded.scale == 1.0f);
+    AI_BMT_CHECK(DequantizedView(encoded).toVector() == zeros);
+
+    // Recycled buffers are handed out again instead of reallocated.
+    const int8_t* buffer = encoded.int8Data.data();
+    encoder.recycle(move(encoded));
+    EncodedTensor again;
+    encoder.encode(zeros.data(), zeros.size(), again);
+    AI_BMT_CHECK(again.int8Data.data() == buffer);
+
+    // A plain vector<float> reads through the same view.
+    const vector<float> plain = { 1.5f, -2.0f };
+    AI_BMT_CHECK(DequantizedView(plain)[1] == -2.0f && DequantizedView(plain).size() == 2);
+
+    return testResult();
+}
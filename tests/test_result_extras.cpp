@@ -0,0 +1,109 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_result_extras.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Minimal implementation that keeps boxes in a side table, like the detection example with detection_output=boxes.
+class ExtrasImplementation : public AI_BMT_Interface, public BMTResultExtrasProvider
+{
+private:
+    BMTResultExtrasTable extras;
+
+public:
+    size_t recycled = 0;
+
+    virtual void Initialize(string) override {}
+    virtual VariantType convertToPreprocessedDataForInference(const string&) override { return vector<float>(); }
+
+    virtual vector<BMTResult> runInference(const vector<VariantType>& data) override
+    {
+        extras.clear([this](BMTResultExtras&) { ++recycled; });
+        vector<BMTResult> results(data.size());
+        for (size_t i = 0; i < results.size(); ++i)
+            extras.emplace(results[i]).objectDetectionBoxes.emplace_back((int)i, 1.0f, 2.0f, 3.0f, 4.0f, 0.5f);
+        return results;
+    }
+
+    virtual void releaseResults(vector<BMTResult>& results) override
+    {
+        extras.release(results, [this](BMTResultExtras&) { ++recycled; });
+    }
+
+    virtual const BMTResultExtras* resultExtras(const BMTResult& result) const override
+    {
+        return extras.find(result);
+    }
+};
+
+class PlainImplementation : public AI_BMT_Interface
+{
+public:
+    virtual void Initialize(string) override {}
+    virtual VariantType convertToPreprocessedDataForInference(const string&) override { return vector<float>(); }
+    virtual vector<BMTResult> runInference(const vector<VariantType>& data) override { return vector<BMTResult>(data.size()); }
+};
+
+int main()
+{
+    // Extras follow the results returned by runInference(..) until they are released.
+    ExtrasImplementation implementation;
+    AI_BMT_Interface& interface = implementation;
+    vector<BMTResult> results = interface.runInference(vector<VariantType>(4));
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BMTResultExtras* extras = findResultExtras(interface, results[i]);
+        AI_BMT_CHECK(extras != nullptr);
+        if (extras != nullptr)
+            AI_BMT_CHECK(extras->objectDetectionBoxes.size() == 1 && extras->objectDetectionBoxes[0].classIndex == (int)i);
+    }
+    const BMTResult unrelated;
+    AI_BMT_CHECK(findResultExtras(interface, unrelated) == nullptr);
+    interface.releaseResults(results);
+    AI_BMT_CHECK(implementation.recycled == 4);
+    AI_BMT_CHECK(findResultExtras(interface, results[0]) == nullptr);
+
+    // Results that are moved or never released lose their extras at the next runInference(..) instead of leaking.
+    vector<BMTResult> unreleased = interface.runInference(vector<VariantType>(3));
+    const vector<BMTResult> moved = move(unreleased);
+    AI_BMT_CHECK(findResultExtras(interface, moved[0]) != nullptr);
+    vector<BMTResult> next = interface.runInference(vector<VariantType>(2));
+    AI_BMT_CHECK(implementation.recycled == 7);
+    AI_BMT_CHECK(findResultExtras(interface, moved[0]) == nullptr);
+    AI_BMT_CHECK(findResultExtras(interface, next[1]) != nullptr);
+    interface.releaseResults(next);
+    AI_BMT_CHECK(implementation.recycled == 9);
+
+    // Implementations without the opt-in interface have no extras.
+    PlainImplementation plain;
+    vector<BMTResult> plainResults = plain.runInference(vector<VariantType>(1));
+    AI_BMT_CHECK(findResultExtras(plain, plainResults[0]) == nullptr);
+
+    // Filled from several threads at once, like the runner's session workers.
+    BMTResultExtrasTable table;
+    vector<BMTResult> batch(4000);
+    vector<thread> workers;
+    for (size_t t = 0; t < 4; ++t)
+        workers.emplace_back([&table, &batch, t] {
+            for (size_t i = t; i < batch.size(); i += 4)
+                table.emplace(batch[i]).segmentationClassMap.assign(3, (uint8_t)(i % 251));
+        });
+    for (thread& worker : workers)
+        worker.join();
+    bool allFound = true;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const BMTResultExtras* extras = table.find(batch[i]);
+        allFound = allFound && extras != nullptr && extras->segmentationClassMap == vector<uint8_t>(3, (uint8_t)(i % 251));
+    }
+    AI_BMT_CHECK(allFound);
+    table.release(batch);
+    AI_BMT_CHECK(table.find(batch[0]) == nullptr && table.size() == 0);
+    table.emplace(batch[1]);
+    table.clear();
+    AI_BMT_CHECK(table.find(batch[1]) == nullptr && table.size() == 0);
+
+    return testResult();
+}
@@ -0,0 +1,56 @@
+#include "ai_bmt_test.h"
+#include "Segmentation_Postprocess.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+static vector<uint8_t> argmaxReference(const vector<float>& logits, size_t channels, size_t planeSize)
+{
+    vector<uint8_t> classMap(planeSize);
+    for (size_t p = 0; p < planeSize; ++p)
+    {
+        size_t best = 0;
+        for (size_t c = 1; c < channels; ++c)
+            if (logits[c * planeSize + p] > logits[best * planeSize + p])
+                best = c;
+        classMap[p] = (uint8_t)best;
+    }
+    return classMap;
+}
+
+// quantized = true draws logits from a handful of values, so most pixels have ties (the lower class must win).
+static void checkArgmax(TestRandom& random, size_t channels, size_t planeSize, bool quantized)
+{
+    vector<float> logits = random.floats(channels * planeSize, -10.0f, 10.0f);
+    if (quantized)
+        for (float& value : logits)
+            value = (float)(int)(value / 5.0f);
+    const vector<uint8_t> expected = argmaxReference(logits, channels, planeSize);
+
+    // One guard byte past the map must stay untouched.
+    vector<uint8_t> scalar(planeSize + 1, 0xAB);
+    argmaxToClassMap(logits.data(), channels, planeSize, scalar.data(), PreprocessingSimdLevel::Scalar);
+    AI_BMT_CHECK(equal(expected.begin(), expected.end(), scalar.begin()));
+    AI_BMT_CHECK(scalar[planeSize] == 0xAB);
+
+    if (preprocessingSimdLevel() == PreprocessingSimdLevel::Scalar)
+        return;
+    vector<uint8_t> simd(planeSize + 1, 0xAB);
+    argmaxToClassMap(logits.data(), channels, planeSize, simd.data(), PreprocessingSimdLevel::AVX2);
+    AI_BMT_CHECK(equal(expected.begin(), expected.end(), simd.begin()));
+    AI_BMT_CHECK(simd[planeSize] == 0xAB);
+}
+
+int main()
+{
+    TestRandom random;
+    // Plane sizes around the 8-pixel block exercise the scalar tail; 256 channels is the uint8 limit.
+    for (size_t channels : { 1, 2, 21, 256 })
+        for (size_t planeSize : { 1, 7, 8, 9, 100 })
+            for (bool quantized : { false, true })
+                checkArgmax(random, channels, planeSize, quantized);
+    checkArgmax(random, 21, 520 * 520, false);
+    checkArgmax(random, 21, 520 * 520, true);
+    return testResult();
+}
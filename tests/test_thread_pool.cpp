@@ -0,0 +1,71 @@
+#include "ai_bmt_test.h"
+#include "ai_bmt_thread_pool.h"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Every index in [0, count) runs exactly once, for counts smaller than, equal to and larger than the worker count.
+static void checkParallelFor(WorkStealingThreadPool& pool, size_t count)
+{
+    unique_ptr<atomic<int>[]> visits(new atomic<int>[count + 1]);
+    for (size_t i = 0; i <= count; ++i)
+        visits[i] = 0;
+    pool.parallelFor(count, [&](size_t i) { visits[i].fetch_add(1); });
+    for (size_t i = 0; i < count; ++i)
+        AI_BMT_CHECK(visits[i].load() == 1);
+    AI_BMT_CHECK(visits[count].load() == 0);
+}
+
+int main()
+{
+    for (size_t threads : { 1, 2, 3, 8 })
+    {
+        WorkStealingThreadPool pool(threads);
+        AI_BMT_CHECK(pool.threadCount() == threads);
+        for (size_t count : { 0, 1, 2, 3, 7, 8, 9, 1000 })
+            checkParallelFor(pool, count);
+    }
+
+    WorkStealingThreadPool pool(4);
+
+    // Uneven item costs: idle workers steal, and the sum is still exact.
+    atomic<uint64_t> sum(0);
+    pool.parallelFor(200, [&](size_t i) {
+        volatile uint64_t spin = 0;
+        for (size_t k = 0; k < (i % 10) * 2000; ++k)
+            spin = spin + k;
+        sum.fetch_add(i);
+    });
+    AI_BMT_CHECK(sum.load() == 199 * 200 / 2);
+
+    // The first exception reaches the caller once every item has finished, and the pool stays usable.
+    atomic<int> finished(0);
+    bool threw = false;
+    try
+    {
+        pool.parallelFor(100, [&](size_t i) {
+            if (i == 42)
+                throw runtime_error("item 42");
+            finished.fetch_add(1);
+        });
+    }
+    catch (const runtime_error&)
+    {
+        threw = true;
+    }
+    AI_BMT_CHECK(threw);
+    AI_BMT_CHECK(finished.load() == 99);
+    checkParallelFor(pool, 50);
+
+    // submit + wait
+    atomic<int> submitted(0);
+    for (int i = 0; i < 64; ++i)
+        pool.submit([&] { submitted.fetch_add(1); });
+    pool.wait();
+    AI_BMT_CHECK(submitted.load() == 64);
+
+    return testResult();
+}
@@ -0,0 +1,183 @@
+#include "ai_bmt_test.h"
+#include "Yolo_Postprocess.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+static bool sameDetections(const vector<Coco17DetectionResult>& a, const vector<Coco17DetectionResult>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].classIndex != b[i].classIndex || a[i].confidence != b[i].confidence || a[i].top_left_x != b[i].top_left_x
+            || a[i].top_left_y != b[i].top_left_y || a[i].width != b[i].width || a[i].height != b[i].height)
+            return false;
+    }
+    return true;
+}
+
+// Random YOLOv5 rows: boxes inside 640x640, about 5% of the objectness values above the threshold.
+static vector<float> randomRowMajorOutput(TestRandom& random, size_t candidates, size_t classes)
+{
+    const size_t stride = 5 + classes;
+    vector<float> output(candidates * stride);
+    for (size_t i = 0; i < candidates; ++i)
+    {
+        float* row = output.data() + i * stride;
+        row[0] = random.uniform(0, 640);
+        row[1] = random.uniform(0, 640);
+        row[2] = random.uniform(4, 200);
+        row[3] = random.uniform(4, 200);
+        row[4] = random.uniform(0, 1) < 0.05f ? random.uniform(0.25f, 1.0f) : random.uniform(0, 0.25f);
+        for (size_t c = 0; c < classes; ++c)
+            row[5 + c] = random.uniform(0, 1);
+    }
+    return output;
+}
+
+// Reference without the objectness prefilter: every row is scored, then the same NMS runs.
+static vector<Coco17DetectionResult> decodeRowMajorReference(const vector<float>& output, size_t candidates, size_t stride,
+    const YoloDecodeSettings& settings)
+{
+    vector<Coco17DetectionResult> detections;
+    for (size_t i = 0; i < candidates; ++i)
+    {
+        const float* row = output.data() + i * stride;
+        size_t best = 0;
+        for (size_t c = 1; c < stride - 5; ++c)
+            if (row[5 + c] > row[5 + best])
+                best = c;
+        const float confidence = row[4] * row[5 + best];
+        if (confidence > settings.confThreshold)
+            detections.emplace_back((int)best, row[0] - row[2] / 2, row[1] - row[3] / 2, row[2], row[3], confidence);
+    }
+    suppressOverlappingDetections(detections, settings);
+    return detections;
+}
+
+static void checkRowMajor(TestRandom& random, size_t candidates, size_t classes)
+{
+    const vector<float> output = randomRowMajorOutput(random, candidates, classes);
+    const YoloDecodeSettings settings;
+    const vector<Coco17DetectionResult> expected = decodeRowMajorReference(output, candidates, 5 + classes, settings);
+    const vector<Coco17DetectionResult> scalar = decodeYoloV5(output.data(), candidates, 5 + classes, settings, PreprocessingSimdLevel::Scalar);
+    AI_BMT_CHECK(!expected.empty() || candidates < 20);
+    AI_BMT_CHECK(sameDetections(scalar, expected));
+    if (preprocessingSimdLevel() != PreprocessingSimdLevel::Scalar)
+        AI_BMT_CHECK(sameDetections(decodeYoloV5(output.data(), candidates, 5 + classes, settings, PreprocessingSimdLevel::AVX2), scalar));
+}
+
+static void checkSuppression()
+{
+    // Two boxes of class 1 overlapping with IoU 0.85 and one of class 0 on top of them.
+    const float rows[3][7] = {
+        { 100, 100, 50, 50, 0.9f, 0.1f, 0.9f },
+        { 102, 102, 50, 50, 0.8f, 0.1f, 0.9f },
+        { 100, 100, 50, 50, 0.7f, 0.9f, 0.1f },
+    };
+    YoloDecodeSettings settings;
+    vector<Coco17DetectionResult> detections = decodeYoloV5(&rows[0][0], 3, 7, settings, PreprocessingSimdLevel::Scalar);
+    AI_BMT_CHECK(detections.size() == 2 && detections[0].classIndex == 1 && detections[1].classIndex == 0);
+    AI_BMT_CHECK_NEAR(detections[0].confidence, 0.81f, 1e-6);
+    AI_BMT_CHECK_NEAR(detections[0].top_left_x, 75.0f, 1e-6);
+    AI_BMT_CHECK_NEAR(detections[0].width, 50.0f, 1e-6);
+
+    settings.classAgnostic = true;
+    AI_BMT_CHECK(decodeYoloV5(&rows[0][0], 3, 7, settings, PreprocessingSimdLevel::Scalar).size() == 1);
+    settings.classAgnostic = false;
+    settings.iouThreshold = 0.9f;
+    AI_BMT_CHECK(decodeYoloV5(&rows[0][0], 3, 7, settings, PreprocessingSimdLevel::Scalar).size() == 3);
+    settings.maxDetections = 2;
+    AI_BMT_CHECK(decodeYoloV5(&rows[0][0], 3, 7, settings, PreprocessingSimdLevel::Scalar).size() == 2);
+}
+
+// Random YOLOv8 planes {4 + classes, candidates}: boxes inside 640x640, about 2% of the candidates with a class above the threshold.
+static vector<float> randomChannelMajorOutput(TestRandom& random, size_t candidates, size_t classes)
+{
+    vector<float> output((4 + classes) * candidates);
+    for (size_t i = 0; i < candidates; ++i)
+    {
+        output[i] = random.uniform(0, 640);
+        output[candidates + i] = random.uniform(0, 640);
+        output[2 * candidates + i] = random.uniform(4, 200);
+        output[3 * candidates + i] = random.uniform(4, 200);
+        const bool object = random.uniform(0, 1) < 0.02f;
+        for (size_t c = 0; c < classes; ++c)
+            output[(4 + c) * candidates + i] = random.uniform(0, object ? 1.0f : 0.25f);
+    }
+    return output;
+}
+
+static void checkChannelMajor(TestRandom& random, size_t candidates, size_t classes)
+{
+    const vector<float> output = randomChannelMajorOutput(random, candidates, classes);
+    const YoloDecodeSettings settings;
+    const vector<Coco17DetectionResult> scalar = decodeYoloV8(output.data(), candidates, classes, settings, PreprocessingSimdLevel::Scalar);
+    for (const Coco17DetectionResult& detection : scalar)
+        AI_BMT_CHECK(detection.confidence > settings.confThreshold && detection.classIndex >= 0 && (size_t)detection.classIndex < classes);
+    if (preprocessingSimdLevel() != PreprocessingSimdLevel::Scalar)
+        AI_BMT_CHECK(sameDetections(decodeYoloV8(output.data(), candidates, classes, settings, PreprocessingSimdLevel::AVX2), scalar));
+}
+
+static void checkOutputFormats()
+{
+    YoloOutputFormat format = YoloOutputFormat::fromShape({ 25200, 85 });
+    AI_BMT_CHECK(format.layout == YoloOutputLayout::RowMajor && format.candidates == 25200 && format.classes == 80);
+    format = YoloOutputFormat::fromShape({ 84, 8400 });
+    AI_BMT_CHECK(format.layout == YoloOutputLayout::ChannelMajor && format.candidates == 8400 && format.classes == 80);
+    format = YoloOutputFormat::fromShape({ 5, 8400 });
+    AI_BMT_CHECK(format.layout == YoloOutputLayout::ChannelMajor && format.classes == 1);
+
+    // {N, 6} is a single-class YOLOv5 or an end-to-end model: only read as end-to-end when the model says so.
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::fromShape({ 300, 6 }));
+    format = YoloOutputFormat::fromShape({ 300, 6 }, true);
+    AI_BMT_CHECK(format.layout == YoloOutputLayout::EndToEnd && format.candidates == 300);
+    format = YoloOutputFormat::withLayout({ 25200, 6 }, YoloOutputLayout::RowMajor);
+    AI_BMT_CHECK(format.layout == YoloOutputLayout::RowMajor && format.candidates == 25200 && format.classes == 1);
+
+    // Forced layouts must fit the shape.
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::withLayout({ 84, 8400 }, YoloOutputLayout::EndToEnd));
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::withLayout({ 300, 4 }, YoloOutputLayout::RowMajor));
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::withLayout({ 4, 8400 }, YoloOutputLayout::ChannelMajor));
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::fromShape({ 84, 8400 }, true));
+
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::fromShape({ 1, 84, 8400 }));
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::fromShape({ 0, 85 }));
+    AI_BMT_CHECK_THROWS(YoloOutputFormat::fromShape({ 4, 4 }));
+}
+
+static void checkEndToEnd()
+{
+    const float rows[3][6] = {
+        { 10, 20, 110, 70, 0.9f, 3 },
+        { 0, 0, 10, 10, 0.1f, 1 },
+        { 5, 5, 25, 45, 0.5f, 7 },
+    };
+    const vector<Coco17DetectionResult> detections = decodeYolo(&rows[0][0], YoloOutputFormat::fromShape({ 3, 6 }, true));
+    AI_BMT_CHECK(detections.size() == 2);
+    if (detections.size() != 2)
+        return;
+    AI_BMT_CHECK(detections[0].classIndex == 3 && detections[1].classIndex == 7);
+    AI_BMT_CHECK(detections[0].top_left_x == 10 && detections[0].width == 100 && detections[1].height == 40);
+}
+
+int main()
+{
+    TestRandom random;
+    // Candidate counts around the 8-row gather exercise the scalar tail.
+    for (size_t candidates : { 1, 7, 8, 9, 63, 1000 })
+        checkRowMajor(random, candidates, 80);
+    checkRowMajor(random, 25200, 80);
+    checkRowMajor(random, 300, 1);
+    checkSuppression();
+
+    for (size_t candidates : { 1, 7, 8, 9, 63, 1000 })
+        checkChannelMajor(random, candidates, 80);
+    checkChannelMajor(random, 8400, 80);
+    checkChannelMajor(random, 100, 1);
+    checkOutputFormats();
+    checkEndToEnd();
+    return testResult();
+}